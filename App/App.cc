@@ -1,14 +1,19 @@
 #include "App.h"
 
 /* C++ */
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
 #include <cstring>
 
 /* Project */
 #include "Com.h"
+#include "Data/LinearFit.h"
+#include "FaultManager.h"
 #include "Fram.h"
 #include "LineSensing/LineSensing.h"
 #include "Mode.h"
+#include "MotionPlaning/CurrentControl.h"
 #include "MotionPlaning/MotionPlaning.h"
 #include "MotionSensing/MotionSensing.h"
 #include "NonVolatileData.h"
@@ -19,6 +24,43 @@
 #include "Ui.h"
 
 #ifndef APP_UNIT_TEST
+/* 速度でスケジュールするPIDゲイン {速度 [m/s], {Kp, Ki, Kd}} */
+/* 並進は全モード共通 */
+static constexpr PidGainSchedule kLinearGainSchedule = {{
+    {1.0f, {5.0f, 80.0f, 0.0f}},
+    {2.0f, {5.0f, 80.0f, 0.0f}},
+    {3.0f, {5.0f, 80.0f, 0.0f}},
+    {5.0f, {5.0f, 80.0f, 0.0f}},
+}};
+/* 探索走行: 各モードの探索速度 (1.2, 1.5, 2.0 m/s) でモードごとに調整したゲインになる */
+static constexpr PidGainSchedule kSearchAngularGainSchedule = {{
+    {1.2f, {0.6f, 20.0f, 0.0f}},
+    {1.5f, {0.6f, 20.0f, 0.0f}},
+    {2.0f, {0.8f, 20.0f, 0.0f}},
+    {5.0f, {0.8f, 20.0f, 0.0f}},
+}};
+static constexpr PidGainSchedule kSearchLineErrorGainSchedule = {{
+    {1.2f, {7.0f, 0.0f, 0.01f}},
+    {1.5f, {7.0f, 0.0f, 0.01f}},
+    {2.0f, {13.0f, 0.0f, 0.01f}},
+    {5.0f, {13.0f, 0.0f, 0.01f}},
+}};
+/* 最短走行: 各モードで調整したゲインを、そのモードの速度マップの最高速度で安定させる値とみなして */
+/* 速度に対して単調になるようにまとめた (0x04: 3.5, 0x05: 4.0, 0x06: 4.3, 0x07: 5.0, 0x10: 2.0 m/s) */
+/* 単調でない 0x10・0x04 のライン追従 (Kp 7, 4.5 / Kd 0.01, 0.005) と 0x04~0x06 の旋回 (0.8, 0.6, 0.6) は平均した */
+static constexpr PidGainSchedule kFastAngularGainSchedule = {{
+    {2.0f, {0.6f, 20.0f, 0.0f}},
+    {3.5f, {0.667f, 20.0f, 0.0f}},
+    {4.3f, {0.667f, 20.0f, 0.0f}},
+    {5.0f, {0.8f, 20.0f, 0.0f}},
+}};
+static constexpr PidGainSchedule kFastLineErrorGainSchedule = {{
+    {2.0f, {5.75f, 0.0f, 0.0075f}},
+    {3.5f, {5.75f, 0.0f, 0.0075f}},
+    {4.3f, {11.0f, 0.0f, 0.01f}},
+    {5.0f, {13.0f, 0.0f, 0.01f}},
+}};
+
 /**
  * MARK: Initialize
  * 初期化
@@ -36,6 +78,13 @@ static void Initialize() {
     Ui::Instance().Fatal();
     printf("NG\r\n");
   }
+  printf("Fault Manager... ");
+  if (FaultManager::Instance().Initialize()) {
+    printf("OK\r\n");
+  } else {
+    printf("NG\r\n");
+    Ui::Instance().Fatal();
+  }
 
   /* ここの順序はPeriodicクラスの呼び出し順になるので注意 */
   printf("Periodic... ");
@@ -73,6 +122,16 @@ static void Initialize() {
     printf("NG\r\n");
     Ui::Instance().Fatal();
   }
+  /* 電源監視のADC変換と共用しても電流制御の割り込みが届き続けるか */
+  printf("Current Control... ");
+  uint32_t currentUpdateCount = MotionPlaning::CurrentControl::Instance().GetUpdateCount();
+  vTaskDelay(pdMS_TO_TICKS(10));
+  if (MotionPlaning::CurrentControl::Instance().GetUpdateCount() != currentUpdateCount) {
+    printf("OK\r\n");
+  } else {
+    printf("NG\r\n");
+    Ui::Instance().Fatal();
+  }
   /* 一番最後に */
   Periodic::Instance().Add(xTaskGetCurrentTaskHandle());
 }
@@ -103,9 +162,145 @@ static void ShowBatteryVoltage() {
          power.GetTick());
 }
 
+/**
+ * MARK: CalibrateLineSensorBySweep
+ * ラインセンサーの自動キャリブレーション (ラインの上でその場旋回し、全センサーにラインと背景を見せる)
+ */
+static bool CalibrateLineSensorBySweep() {
+  auto &ls = LineSensing::LineSensing::Instance();
+  auto &ms = MotionSensing::MotionSensing::Instance();
+  auto &mp = MotionPlaning::MotionPlaning::Instance();
+  auto &servo = mp.Servo();
+  auto &odometry = ms.Odometry();
+  auto &fault = FaultManager::Instance();
+  auto &ui = Ui::Instance();
+
+  /* 手が離れるまで待つ */
+  vTaskDelay(pdMS_TO_TICKS(1000));
+  if (!ms.PrepareImu()) {
+    return false;
+  }
+  servo.SetGainSchedule(kLinearGainSchedule, kSearchAngularGainSchedule);
+  ls.ResetCalibrationSample();
+  ms.NotifyStart();
+  mp.NotifyStart();
+
+  /* 1周期待ってから旋回開始時の角度を取る */
+  bool success = Periodic::WaitPeriodicNotify();
+  float start = odometry.GetDisplacement().rot;
+  float velocity = 0.0f;
+  while (success) {
+    if (!Periodic::WaitPeriodicNotify() || servo.IsEmergency() || fault.IsStopRequired() ||
+        ui.WaitPress(0) >= kButtonShortPressThreshold) {
+      success = false;
+      break;
+    }
+    float angle = std::abs(odometry.GetDisplacement().rot - start);
+    if (angle >= kLineCalibrationSweepAngle) {
+      break;
+    }
+    /* 台形の角速度 (残りの角度で止まれる速度を超えない) */
+    float stoppable = std::sqrt(2.0f * kLineCalibrationSweepAcceleration * (kLineCalibrationSweepAngle - angle));
+    velocity = std::min({velocity + kLineCalibrationSweepAcceleration * kPeriodicNotifyInterval,
+                         kLineCalibrationSweepVelocity, stoppable});
+    servo.SetTarget(0.0f, velocity);
+    success = ls.SampleCalibration();
+  }
+  if (success) {
+    servo.SetTarget(0.0f, 0.0f); /* フィードバックで停止 */
+  } else {
+    servo.EmergencyStop();
+  }
+  vTaskDelay(pdMS_TO_TICKS(500));
+  mp.NotifyStop();
+  ms.NotifyStop();
+  return success && ls.FinishCalibration();
+}
+
+/**
+ * MARK: IdentifyLineOffset
+ * ラインセンサーエラーから横ずれへの換算を同定 (ラインに沿って車軸をライン上に置き、その場旋回でセンサーを横に振る)
+ */
+static bool IdentifyLineOffset() {
+  auto &ls = LineSensing::LineSensing::Instance();
+  auto &ms = MotionSensing::MotionSensing::Instance();
+  auto &mp = MotionPlaning::MotionPlaning::Instance();
+  const auto &line = ls.Line();
+  auto &servo = mp.Servo();
+  auto &odometry = ms.Odometry();
+  auto &fault = FaultManager::Instance();
+  auto &ui = Ui::Instance();
+
+  /* 手が離れるまで待つ */
+  vTaskDelay(pdMS_TO_TICKS(1000));
+  if (!ms.PrepareImu()) {
+    return false;
+  }
+  servo.SetGainSchedule(kLinearGainSchedule, kSearchAngularGainSchedule);
+  ms.NotifyStart();
+  ls.NotifyStart();
+  mp.NotifyStart();
+
+  /* 1周期待ってから旋回開始時の角度 (ラインの向き) を取る */
+  bool success = Periodic::WaitPeriodicNotify();
+  float start = odometry.GetDisplacement().rot;
+  /* 横ずれは幾何で正確に分かり、ノイズはエラー側に乗るので エラー = 傾き × 横ずれ で回帰して逆数を取る */
+  LinearFit fit;
+  /* 左右に振ってから元の向きへ戻る (往復で移動平均の遅れを打ち消す) */
+  for (float target : {kLineOffsetIdentAngle, -kLineOffsetIdentAngle, 0.0f}) {
+    float direction = target > odometry.GetDisplacement().rot - start ? 1.0f : -1.0f;
+    float velocity = 0.0f;
+    while (success) {
+      if (!Periodic::WaitPeriodicNotify() || servo.IsEmergency() || fault.IsStopRequired() ||
+          ui.WaitPress(0) >= kButtonShortPressThreshold) {
+        success = false;
+        break;
+      }
+      float angle = odometry.GetDisplacement().rot - start;
+      float remaining = (target - angle) * direction;
+      if (remaining <= 0.0f) {
+        break;
+      }
+      if (line.GetState() == LineSensing::LineImpl::State::kNormal) {
+        fit.Add(kLineDistanceFromCenter * std::tan(angle), line.GetError());
+      }
+      /* 台形の角速度 (残りの角度で止まれる速度を超えず、止まりきる前に目標を越える) */
+      float step = kLineOffsetIdentAcceleration * kPeriodicNotifyInterval;
+      float stoppable = std::sqrt(2.0f * kLineOffsetIdentAcceleration * remaining) + step;
+      velocity = std::min({velocity + step, kLineOffsetIdentVelocity, stoppable});
+      servo.SetTarget(0.0f, direction * velocity);
+    }
+  }
+  if (success) {
+    servo.SetTarget(0.0f, 0.0f); /* フィードバックで停止 */
+  } else {
+    servo.EmergencyStop();
+  }
+  vTaskDelay(pdMS_TO_TICKS(500));
+  mp.NotifyStop();
+  ls.NotifyStop();
+  ms.NotifyStop();
+
+  float slope = 0.0f, intercept = 0.0f;
+  if (!success || fit.GetCount() < kLineOffsetIdentMinSamples || !fit.Get(slope, intercept) || slope <= 0.0f) {
+    printf("IdentifyLineOffset failed: %ld samples, slope %f\r\n", fit.GetCount(), static_cast<double>(slope));
+    return false;
+  }
+  float errorToOffset = 1.0f / slope;
+  printf(" ----- IdentifyLineOffset(%ld) ----- \r\n", fit.GetCount());
+  printf("ErrorToOffset: %f [m], ErrorAtCenter: %f\r\n", static_cast<double>(errorToOffset),
+         static_cast<double>(intercept));
+  /* 符号が逆・大きすぎる場合は置き方が悪い */
+  if (errorToOffset > kLineOffsetIdentMaxGain) {
+    return false;
+  }
+  return ls.StoreOffsetGain(errorToOffset);
+}
+
 extern "C" void vAPP_TaskEntry() {
   Initialize();
   ShowBatteryVoltage();
+  FaultManager::Instance().PrintHistory(kFaultHistoryPrintRecords);
 
   auto &ui = Ui::Instance();
 
@@ -113,6 +308,12 @@ extern "C" void vAPP_TaskEntry() {
   if (!LineSensing::LineSensing::Instance().LoadCalibrationData()) {
     ui.Fatal();
   }
+  /* 未保存の場合は走行前にキャリブレーションする */
+  MotionSensing::MotionSensing::Instance().LoadImuBias();
+  /* 未同定の場合は初期値で補償する */
+  MotionPlaning::MotionPlaning::Instance().LoadFriction();
+  /* 未同定の場合は状態フィードバックで走行しない */
+  LineSensing::LineSensing::Instance().LoadOffsetGain();
 
   /* スイッチから手が離れるまで待つ */
   ui.SetBuzzer(kBuzzerFrequency, kBuzzerEnterDuration);
@@ -129,16 +330,18 @@ extern "C" void vAPP_TaskEntry() {
         /* 探索走行(非吸引で確実に走る速度、位置精度を向上させるために一応吸う) */
         /* TODO: 加速度を上げる */
         Trace::Parameter param = {
-            Trace::Mode::kSearchRunning, /* モード */
-            1,                           /* ログ周期 [ms] */
-            1.2f,                        /* 探索上限速度・最短時初期速度 [m/s] */
-            5.0f,                        /* 加速度 [m/ss] */
-            0.0f,                        /* 最短時減速度 [m/ss] */
-            {5.0f, 0.08f, 0.0f},         /* 並進PIDゲイン */
-            {0.6f, 0.02f, 0.0f},         /* 旋回PIDゲイン */
-            {7.0f, 0.0f, 0.01f},         /* ライン追従PIDゲイン */
-            0.2f,                        /* ゴールマーカーから停止までの距離 [m] */
-            2.0f,                        /* 吸引電圧 [V] */
+            Trace::Mode::kSearchRunning,  /* モード */
+            1,                            /* ログ周期 [ms] */
+            1.2f,                         /* 探索上限速度・最短時初期速度 [m/s] */
+            5.0f,                         /* 加速度 [m/ss] */
+            0.0f,                         /* 最短時減速度 [m/ss] */
+            kLinearGainSchedule,          /* 並進PIDゲイン */
+            kSearchAngularGainSchedule,   /* 旋回PIDゲイン */
+            kSearchLineErrorGainSchedule, /* ライン追従PIDゲイン */
+            false,                        /* 状態フィードバックでライン追従 */
+            0.2f,                         /* ゴールマーカーから停止までの距離 [m] */
+            2.0f,                         /* 吸引電圧 [V] */
+            2.0f,                         /* 直線での吸引電圧 [V] */
         };
         trace.Run(param);
       } break;
@@ -146,32 +349,36 @@ extern "C" void vAPP_TaskEntry() {
         /* 探索走行(吸引で確実に走る速度、最短走行が成功しない場合にタイムを縮めるために使用) */
         /* TODO: 加速度を上げる */
         Trace::Parameter param = {
-            Trace::Mode::kSearchRunning, /* モード */
-            10,                          /* ログ周期 [ms] */
-            1.5f,                        /* 探索速度[m/s] */
-            5.0f,                        /* 加速度 [m/ss] */
-            0.0f,                        /* 最短時減速度 [m/ss] */
-            {5.0f, 0.08f, 0.0f},         /* 並進PIDゲイン */
-            {0.6f, 0.02f, 0.0f},         /* 旋回PIDゲイン */
-            {7.0f, 0.0f, 0.01f},         /* ライン追従PIDゲイン */
-            0.2f,                        /* ゴールマーカーから停止までの距離 [m] */
-            2.0f,                        /* 吸引電圧 [V] */
+            Trace::Mode::kSearchRunning,  /* モード */
+            10,                           /* ログ周期 [ms] */
+            1.5f,                         /* 探索速度[m/s] */
+            5.0f,                         /* 加速度 [m/ss] */
+            0.0f,                         /* 最短時減速度 [m/ss] */
+            kLinearGainSchedule,          /* 並進PIDゲイン */
+            kSearchAngularGainSchedule,   /* 旋回PIDゲイン */
+            kSearchLineErrorGainSchedule, /* ライン追従PIDゲイン */
+            false,                        /* 状態フィードバックでライン追従 */
+            0.2f,                         /* ゴールマーカーから停止までの距離 [m] */
+            2.0f,                         /* 吸引電圧 [V] */
+            2.0f,                         /* 直線での吸引電圧 [V] */
         };
         trace.Run(param);
       } break;
       case 0x03: {
         /* 探索走行(吸引で大体走る速度、最短走行が成功しない場合にタイムを縮めるために使用・最短ゲイン調整用) */
         Trace::Parameter param = {
-            Trace::Mode::kSearchRunning, /* モード */
-            1,                           /* ログ周期 [ms] */
-            2.0f,                        /* 探索速度[m/s] */
-            10.0f,                       /* 加速度 [m/ss] */
-            0.0f,                        /* 最短時減速度 [m/ss] */
-            {5.0f, 0.08f, 0.0f},         /* 並進PIDゲイン */
-            {0.8f, 0.02f, 0.0f},         /* 旋回PIDゲイン */
-            {13.0f, 0.0f, 0.01f},        /* ライン追従PIDゲイン */
-            0.2f,                        /* ゴールマーカーから停止までの距離 [m] */
-            4.0f,                        /* 吸引電圧 [V] */
+            Trace::Mode::kSearchRunning,  /* モード */
+            1,                            /* ログ周期 [ms] */
+            2.0f,                         /* 探索速度[m/s] */
+            10.0f,                        /* 加速度 [m/ss] */
+            0.0f,                         /* 最短時減速度 [m/ss] */
+            kLinearGainSchedule,          /* 並進PIDゲイン */
+            kSearchAngularGainSchedule,   /* 旋回PIDゲイン */
+            kSearchLineErrorGainSchedule, /* ライン追従PIDゲイン */
+            false,                        /* 状態フィードバックでライン追従 */
+            0.2f,                         /* ゴールマーカーから停止までの距離 [m] */
+            4.0f,                         /* 吸引電圧 [V] */
+            4.0f,                         /* 直線での吸引電圧 [V] */
         };
         trace.Run(param);
       } break;
@@ -186,16 +393,18 @@ extern "C" void vAPP_TaskEntry() {
             1.0f, 2.0f, 2.2f, 3.0f, 3.2f, 3.5f,
         };
         Trace::Parameter param = {
-            Trace::Mode::kFastRunning, /* モード */
-            10,                        /* ログ周期 [ms] */
-            2.0f,                      /* スタート時目標速度[m/s] */
-            6.0f,                      /* 加速度 [m/ss] */
-            6.0f,                      /* 最短時減速度 [m/ss] */
-            {5.0f, 0.08f, 0.0f},       /* 並進PIDゲイン */
-            {0.8f, 0.02f, 0.0f},       /* 旋回PIDゲイン */
-            {4.5f, 0.0f, 0.005f},      /* ライン追従PIDゲイン */
-            0.2f,                      /* ゴールマーカーから停止までの距離 [m] */
-            3.5f,                      /* 吸引電圧 [V] */
+            Trace::Mode::kFastRunning,  /* モード */
+            10,                         /* ログ周期 [ms] */
+            2.0f,                       /* スタート時目標速度[m/s] */
+            6.0f,                       /* 加速度 [m/ss] */
+            6.0f,                       /* 最短時減速度 [m/ss] */
+            kLinearGainSchedule,        /* 並進PIDゲイン */
+            kFastAngularGainSchedule,   /* 旋回PIDゲイン */
+            kFastLineErrorGainSchedule, /* ライン追従PIDゲイン */
+            false,                      /* 状態フィードバックでライン追従 */
+            0.2f,                       /* ゴールマーカーから停止までの距離 [m] */
+            3.5f,                       /* 吸引電圧 [V] */
+            2.0f,                       /* 直線での吸引電圧 [V] */
         };
         trace.CalculateVelocityMap(minRadius, maxVelocity, param.maxVelocity, param.acceleration, param.deceleration);
         trace.Run(param);
@@ -211,16 +420,18 @@ extern "C" void vAPP_TaskEntry() {
             1.5f, 2.0f, 2.5f, 3.0f, 3.5f, 4.0f,
         };
         Trace::Parameter param = {
-            Trace::Mode::kFastRunning, /* モード */
-            10,                        /* ログ周期 [ms] */
-            2.0f,                      /* スタート時目標速度[m/s] */
-            8.0f,                      /* 加速度 [m/ss] */
-            8.0f,                      /* 最短時減速度 [m/ss] */
-            {5.0f, 0.08f, 0.0f},       /* 並進PIDゲイン */
-            {0.6f, 0.02f, 0.0f},       /* 旋回PIDゲイン */
-            {9.0f, 0.0f, 0.01f},       /* ライン追従PIDゲイン */
-            0.2f,                      /* ゴールマーカーから停止までの距離 [m] */
-            3.5f,                      /* 吸引電圧 [V] */
+            Trace::Mode::kFastRunning,  /* モード */
+            10,                         /* ログ周期 [ms] */
+            2.0f,                       /* スタート時目標速度[m/s] */
+            8.0f,                       /* 加速度 [m/ss] */
+            8.0f,                       /* 最短時減速度 [m/ss] */
+            kLinearGainSchedule,        /* 並進PIDゲイン */
+            kFastAngularGainSchedule,   /* 旋回PIDゲイン */
+            kFastLineErrorGainSchedule, /* ライン追従PIDゲイン */
+            false,                      /* 状態フィードバックでライン追従 */
+            0.2f,                       /* ゴールマーカーから停止までの距離 [m] */
+            3.5f,                       /* 吸引電圧 [V] */
+            2.0f,                       /* 直線での吸引電圧 [V] */
         };
         trace.CalculateVelocityMap(minRadius, maxVelocity, param.maxVelocity, param.acceleration, param.deceleration);
         trace.Run(param);
@@ -236,16 +447,18 @@ extern "C" void vAPP_TaskEntry() {
             1.8f, 2.3f, 2.8f, 3.3f, 3.8f, 4.3f,
         };
         Trace::Parameter param = {
-            Trace::Mode::kFastRunning, /* モード */
-            1,                         /* ログ周期 [ms] */
-            2.0f,                      /* スタート時目標速度[m/s] */
-            8.0f,                      /* 加速度 [m/ss] */
-            8.0f,                      /* 最短時減速度 [m/ss] */
-            {5.0f, 0.08f, 0.0f},       /* 並進PIDゲイン */
-            {0.6f, 0.02f, 0.0f},       /* 旋回PIDゲイン */
-            {11.0f, 0.0f, 0.01f},      /* ライン追従PIDゲイン */
-            0.2f,                      /* ゴールマーカーから停止までの距離 [m] */
-            4.0f,                      /* 吸引電圧 [V] */
+            Trace::Mode::kFastRunning,  /* モード */
+            1,                          /* ログ周期 [ms] */
+            2.0f,                       /* スタート時目標速度[m/s] */
+            8.0f,                       /* 加速度 [m/ss] */
+            8.0f,                       /* 最短時減速度 [m/ss] */
+            kLinearGainSchedule,        /* 並進PIDゲイン */
+            kFastAngularGainSchedule,   /* 旋回PIDゲイン */
+            kFastLineErrorGainSchedule, /* ライン追従PIDゲイン */
+            false,                      /* 状態フィードバックでライン追従 */
+            0.2f,                       /* ゴールマーカーから停止までの距離 [m] */
+            4.0f,                       /* 吸引電圧 [V] */
+            2.5f,                       /* 直線での吸引電圧 [V] */
         };
         trace.CalculateVelocityMap(minRadius, maxVelocity, param.maxVelocity, param.acceleration, param.deceleration);
         trace.Run(param);
@@ -261,16 +474,18 @@ extern "C" void vAPP_TaskEntry() {
             2.0f, 2.2f, 3.0f, 3.5f, 4.0f, 4.5f, 5.0f,
         };
         Trace::Parameter param = {
-            Trace::Mode::kFastRunning, /* モード */
-            1,                         /* ログ周期 [ms] */
-            2.0f,                      /* スタート時目標速度[m/s] */
-            8.0f,                      /* 加速度 [m/ss] */
-            8.0f,                      /* 最短時減速度 [m/ss] */
-            {5.0f, 0.08f, 0.0f},       /* 並進PIDゲイン */
-            {0.8f, 0.02f, 0.0f},       /* 旋回PIDゲイン */
-            {13.0f, 0.0f, 0.01f},      /* ライン追従PIDゲイン */
-            0.2f,                      /* ゴールマーカーから停止までの距離 [m] */
-            4.0f,                      /* 吸引電圧 [V] */
+            Trace::Mode::kFastRunning,  /* モード */
+            1,                          /* ログ周期 [ms] */
+            2.0f,                       /* スタート時目標速度[m/s] */
+            8.0f,                       /* 加速度 [m/ss] */
+            8.0f,                       /* 最短時減速度 [m/ss] */
+            kLinearGainSchedule,        /* 並進PIDゲイン */
+            kFastAngularGainSchedule,   /* 旋回PIDゲイン */
+            kFastLineErrorGainSchedule, /* ライン追従PIDゲイン */
+            false,                      /* 状態フィードバックでライン追従 */
+            0.2f,                       /* ゴールマーカーから停止までの距離 [m] */
+            4.0f,                       /* 吸引電圧 [V] */
+            2.5f,                       /* 直線での吸引電圧 [V] */
         };
         trace.CalculateVelocityMap(minRadius, maxVelocity, param.maxVelocity, param.acceleration, param.deceleration);
         trace.Run(param);
@@ -296,19 +511,36 @@ extern "C" void vAPP_TaskEntry() {
       case 0x0c: {
         trace.PrintVelocityTable();
       } break;
+      case 0x0d: {
+        /* ラインセンサーの自動キャリブレーション (ラインの上に置いてから開始) */
+        if (!CalibrateLineSensorBySweep()) {
+          ui.Warn();
+        }
+        ui.SetBuzzer(kBuzzerFrequency, kBuzzerEnterDuration);
+      } break;
+      case 0x0e: {
+        /* ラインセンサーエラーから横ずれへの換算を同定 (ラインに沿って置いてから開始) */
+        if (!IdentifyLineOffset()) {
+          ui.Warn();
+        }
+        ui.SetBuzzer(kBuzzerFrequency, kBuzzerEnterDuration);
+      } break;
       case 0x10: {
         /* (これを本番で使うことはない)最短走行調整用 */
+        /* 状態フィードバックはモード0x0eで横ずれへの換算を同定してから使う */
         Trace::Parameter param = {
-            Trace::Mode::kFastRunning, /* モード */
-            10,                        /* ログ周期 [ms] */
-            1.0f,                      /* スタート時目標速度[m/s] */
-            6.0f,                      /* 加速度 [m/ss] */
-            6.0f,                      /* 最短時減速度 [m/ss] */
-            {5.0f, 0.08f, 0.0f},       /* 並進PIDゲイン */
-            {0.6f, 0.02f, 0.0f},       /* 旋回PIDゲイン */
-            {7.0f, 0.0f, 0.01f},       /* ライン追従PIDゲイン */
-            0.2f,                      /* ゴールマーカーから停止までの距離 [m] */
-            0.0f,                      /* 吸引電圧 [V] */
+            Trace::Mode::kFastRunning,  /* モード */
+            10,                         /* ログ周期 [ms] */
+            1.0f,                       /* スタート時目標速度[m/s] */
+            6.0f,                       /* 加速度 [m/ss] */
+            6.0f,                       /* 最短時減速度 [m/ss] */
+            kLinearGainSchedule,        /* 並進PIDゲイン */
+            kFastAngularGainSchedule,   /* 旋回PIDゲイン */
+            kFastLineErrorGainSchedule, /* ライン追従PIDゲイン */
+            true,                       /* 状態フィードバックでライン追従 */
+            0.2f,                       /* ゴールマーカーから停止までの距離 [m] */
+            0.0f,                       /* 吸引電圧 [V] */
+            0.0f,                       /* 直線での吸引電圧 [V] */
         };
         std::vector<float> minRadius = {
             0.2f, 0.4f, 0.6f, 0.8f, 1.0f,
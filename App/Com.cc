@@ -40,7 +40,7 @@ bool Com::Initialize() {
 bool Com::Write(const void *data, uint32_t size) {
   ComRequest request = {ComRequest::Type::kWrite, reinterpret_cast<const uint8_t *>(data), nullptr, size};
   ComResponse response = {};
-  if (Send(request) && Receive(response)) {
+  if (Transact(request, response)) {
     return response == ComResponse::kSuccess;
   }
   return false;
@@ -50,7 +50,7 @@ bool Com::Write(const void *data, uint32_t size) {
 bool Com::Read(void *data, uint32_t size) {
   ComRequest request = {ComRequest::Type::kRead, nullptr, reinterpret_cast<uint8_t *>(data), size};
   ComResponse response = {};
-  if (Send(request) && Receive(response)) {
+  if (Transact(request, response)) {
     return response == ComResponse::kSuccess;
   }
   return false;
@@ -24,6 +24,16 @@ constexpr uint32_t kBatteryVoltageNumMovingAverage = 16; /* バッテリー電
 constexpr uint32_t kBatteryErrorTime = 5000;             /* 異常とするバッテリー電圧下限以下の連続時間 [ms] */
 constexpr uint32_t kPowerAdcErrorTime = 5000;            /* 異常とするADC取得失敗連続回数 */
 
+/* バッテリーモデル (開放電圧と内部抵抗をカルマンフィルタで推定) */
+constexpr float kBatteryInternalResistance = 0.1f;      /* 内部抵抗の初期値[Ω] */
+constexpr float kBatteryModelVoltageNoise = 0.05f;      /* 電圧計測ノイズ[V] */
+constexpr float kBatteryModelOcvDrift = 1.0e-3f;        /* 開放電圧の変動[V/√s] */
+constexpr float kBatteryModelResistanceDrift = 1.0e-4f; /* 内部抵抗の変動[Ω/√s] */
+
+/* フォールト管理 */
+constexpr uint32_t kFaultHistoryNumRecords = 32;  /* FRAMに残すフォールト履歴の件数 */
+constexpr uint32_t kFaultHistoryPrintRecords = 8; /* 起動時に表示するフォールト履歴の件数 */
+
 /* モーター */
 constexpr float kTorqueConstant = 4.83e-3f;                            /* モータートルク定数[N*m/A] */
 constexpr float kMotorBackEmf = 1.0f / 1980.0f;                        /* モーター起電力定数[V/rpm] */
@@ -32,9 +42,52 @@ constexpr float kMotorLimitVoltage = 12.6f;                            /* モー
 constexpr float kMotorCurrentMeasureDivResistor = 4.99e3f;             /* モーター電流計測分圧抵抗[Ω] */
 constexpr float kMotorCurrentMeasureOffset = kRegulatorVoltage / 2.0f; /* モーター電流計測オフセット[V] */
 constexpr float kSuctionFanLimitVoltage = 3.7f;                        /* 吸引ファン上限電圧[V] */
+constexpr float kMotorMixedDecayRatio = 0.5f;                          /* 混合減衰でオフ期間をブレーキにする割合 */
+
+/* 電流制御 */
+constexpr uint32_t kMotorPwmFrequency = 100000;      /* モーターPWM周波数[Hz] */
+constexpr bool kMotorPwmDithering = true;            /* デューティの端数をΣΔ変調で次の周期へ繰り越すか */
+constexpr uint32_t kCurrentControlFrequency = 20000; /* 電流制御周波数[Hz] */
+constexpr float kCurrentControlKp = 1.0f;            /* 電流制御比例ゲイン[V/A] */
+constexpr float kCurrentControlKi = 2000.0f;         /* 電流制御積分ゲイン[V/(A*s)] */
+constexpr float kMotorCurrentLimit = 3.0f;           /* モーター電流指令上限[A] */
+constexpr uint32_t kAdcStopTimeout = 2;              /* ADC2 レギュラー変換停止待ちタイムアウト[ms] */
+
+/* モーター温度モデル */
+constexpr float kMotorAmbientTemperature = 25.0f;                  /* 周囲温度(kMotorResistanceの測定温度)[℃] */
+constexpr float kMotorResistanceTemperatureCoefficient = 3.93e-3f; /* 巻線抵抗の温度係数(銅)[1/K] */
+constexpr float kMotorThermalResistance = 30.0f;                   /* 巻線から周囲への熱抵抗[K/W] */
+constexpr float kMotorThermalTimeConstant = 60.0f;                 /* 熱時定数[s] */
+constexpr float kMotorTemperatureLimit = 100.0f;                   /* 巻線上限温度[℃] */
+constexpr float kMotorDeratingHorizon = 5.0f;                      /* 許容電流を決める予測時間[s] */
+
+/* 状態推定 (カルマンフィルタ) */
+constexpr float kEstimatorAccelNoise = 0.5f;            /* 加速度センサーノイズ[m/ss] */
+constexpr float kEstimatorAccelBiasDrift = 0.01f;       /* 加速度センサーバイアス変動[m/ss/√s] */
+constexpr float kEstimatorEncoderVelocityNoise = 0.01f; /* エンコーダー速度ノイズ[m/s] */
+constexpr float kEstimatorYawAccelNoise = 50.0f;        /* 角加速度の変動[rad/ss] */
+constexpr float kEstimatorGyroNoise = 0.01f;            /* ジャイロノイズ[rad/s] */
+constexpr float kEstimatorGyroBiasDrift = 1.0e-4f;      /* ジャイロバイアス変動[rad/s/√s] */
+constexpr float kEstimatorEncoderYawRateNoise = 0.5f;   /* エンコーダー角速度ノイズ(滑り込み)[rad/s] */
 
-/* エンコーダー */
-constexpr uint32_t kEncoderNumMovingAverage = 4; /* エンコーダー移動平均サンプル数 */
+/* スリップ検出・トラクション制御 */
+constexpr float kSlipFilterTimeConstant = 0.01f;     /* 加速度比較の一次遅れ時定数[s] */
+constexpr float kSlipAccelerationThreshold = 4.0f;   /* スリップとする車輪と車体の加速度差[m/ss] */
+constexpr uint32_t kSlipDetectTime = 5;              /* スリップ判定に必要な連続時間[ms] */
+constexpr uint32_t kSlipReleaseTime = 20;            /* スリップ解除に必要な連続時間[ms] */
+constexpr float kSlipEncoderNoiseScale = 100.0f;     /* スリップ中のエンコーダー速度ノイズ倍率 */
+constexpr float kTractionAccelerationScale = 0.5f;   /* スリップ中の加減速度倍率 */
+constexpr float kTractionVelocityMargin = 0.1f;      /* スリップ中に許す目標速度と推定速度の差[m/s] */
+
+/* IMU */
+constexpr uint32_t kImuNumCalibrationSample = 1000;  /* IMUキャリブレーションサンプル数 */
+constexpr uint32_t kImuTemperatureWaitTime = 200;    /* IMU温度取得待ち時間[ms] */
+constexpr float kImuBiasTableMinTemperature = 10.0f; /* IMUバイアステーブル最低温度[degC] */
+constexpr float kImuBiasTableTemperatureStep = 5.0f; /* IMUバイアステーブル温度間隔[degC] */
+constexpr uint32_t kImuBiasTableNumPoints = 9;       /* IMUバイアステーブル点数(10〜50degC) */
+constexpr uint32_t kImuStationaryTime = 500;         /* バイアス再推定に必要な静止時間[ms] */
+constexpr float kImuStationaryYawRate = 0.02f;       /* 静止とみなすヨーレート上限[rad/s] */
+constexpr float kImuBiasUpdateGain = 0.2f;           /* 静止時バイアス再推定の更新ゲイン */
 
 /* FF項 */
 constexpr float kFeedForwardLinearGain = 0.0f;  /* 並進方向 TODO: */
@@ -46,6 +99,22 @@ constexpr uint32_t kServoErrorLinearTime = 500;  /* 異常とする下限速度
 constexpr float kServoErrorAngularGain = 0.5f;   /* 目標角速度を元にした下限角速度のゲイン */
 constexpr uint32_t kServoErrorAngularTime = 500; /* 異常とする下限角速度未満連続時間[ms] */
 
+/* 摩擦補償 (同定値が無い場合は初期値を使う) */
+constexpr float kFrictionBreakawayVoltage = 0.3f;   /* 起動電圧の初期値[V] */
+constexpr float kFrictionCoulombVoltage = 0.2f;     /* クーロン摩擦電圧の初期値[V] */
+constexpr float kFrictionViscousVoltage = 0.0f;     /* 粘性摩擦係数の初期値[V/(m/s)] */
+constexpr float kFrictionVelocityThreshold = 0.05f; /* 目標車輪速度がこれ未満なら補償を比例で弱める[m/s] */
+constexpr float kFrictionStaticVelocity = 0.02f;    /* 車輪速度がこれ未満なら起動電圧で補償[m/s] */
+constexpr float kFrictionIdentRampRate = 0.5f;      /* 同定時の電圧上昇率[V/s] */
+constexpr float kFrictionIdentMaxVoltage = 3.0f;    /* 同定時の上限電圧[V] */
+
+/* ゲインスケジュール */
+constexpr uint32_t kGainScheduleNumPoints = 4; /* ゲインスケジュール点数 */
+
+/* ライン追従 */
+constexpr float kLineErrorDerivativeTimeConstant = 2.0e-3f; /* ライン追従PID微分フィルタ時定数[s] */
+constexpr float kLineErrorMaxAngularVelocity = 30.0f;       /* ライン追従最大角速度[rad/s] */
+
 /* 周期通知 (Periodic) */
 constexpr float kPeriodicNotifyInterval = 1.0e-3f; /* センサー更新間隔[s] */
 
@@ -56,12 +125,77 @@ constexpr uint8_t kLineCrossDetectNum = 8;           /* ラインセンサー交
 constexpr float kLineDistanceFromCenter = 81.04e-3f; /* ラインセンサーから車軸までの距離[m] */
 constexpr float kLineDistanceFromMarker = 49.63e-3f; /* ラインセンサーからマーカーセンサーまでの距離[m] */
 constexpr float kLineBrownOutIgnoreDistance = 0.1f;  /* ラインセンサーブラウンアウト無視距離[m] */
-constexpr float kLineDetectThreshold = 0.6f;         /* ラインセンサー検知しきい値 */
+constexpr float kLineDetectThreshold = 0.6f;         /* ラインセンサー検知しきい値(上限に対する割合) */
 constexpr float kMarkerDetectDistance = 0.010f;      /* マーカー検知距離[m] */
 constexpr uint32_t kMarkerNumMovingAverage = 4;      /* ラインセンサー移動平均サンプル数 */
 constexpr float kMarkerDetectThreshold = 0.5f;       /* マーカーセンサー検知しきい値 */
 constexpr float kMarkerIgnoreOffset = 0.05f;         /* マーカー検知無視オフセット[m] */
 
+/* センサーしきい値の追従 (環境光・路面・吸引による車高の変化) */
+constexpr float kSensorEnvelopeDistance = 0.5f;    /* 下限・上限を追従させる距離の時定数[m] */
+constexpr float kSensorEnvelopeMinRatio = 0.5f;    /* 上限を下げられるキャリブレーション値の倍率 */
+constexpr float kSensorEnvelopeMaxRatio = 1.5f;    /* 上限を上げられるキャリブレーション値の倍率 */
+constexpr float kSensorEnvelopeMinContrast = 0.3f; /* 下限と上限の最小の差(キャリブレーション時の差に対する割合) */
+constexpr float kSensorEnvelopeClassify = 0.2f;    /* ラインセンサーの正規化値がこれ未満なら背景として下限を追従 */
+
+/* ラインセンサーの健全性監視 (異常なチャンネルは推定から外して両隣で補間) */
+constexpr float kLineHealthWindow = 0.5f;       /* 固着を判定する区間[m] */
+constexpr uint16_t kLineHealthStuckRange = 1;   /* 区間内の変化がこれ以下なら固着[LSB] */
+constexpr float kLineHealthMinContrast = 0.4f;  /* 下限と上限の差の下限(キャリブレーション時の差に対する割合) */
+constexpr float kLineHealthNoiseFilter = 0.01f; /* 背景での1周期の変化量の平均の更新係数 */
+constexpr float kLineHealthMaxNoise = 0.1f;     /* 変化量の平均の上限(キャリブレーション時の差に対する割合) */
+
+/* ラインセンサーキャリブレーション (ヒストグラムの分位点で外れ値を除く) */
+constexpr uint32_t kLineCalibrationNumBins = 128;          /* ヒストグラムのビン数 */
+constexpr float kLineCalibrationMinPercentile = 0.05f;     /* 最小値とする分位点 (背景が大半を占める) */
+constexpr float kLineCalibrationMaxPercentile = 0.99f;     /* 最大値とする分位点 (ライン上は数%) */
+constexpr uint16_t kLineCalibrationMinContrast = 100;      /* 最大値と最小値の差の下限[LSB] */
+constexpr float kLineCalibrationSweepVelocity = 6.0f;      /* 自動キャリブレーションの旋回速度[rad/s] */
+constexpr float kLineCalibrationSweepAcceleration = 12.0f; /* 自動キャリブレーションの旋回加速度[rad/ss] */
+constexpr float kLineCalibrationSweepAngle = 12.6f;        /* 自動キャリブレーションで回る角度(2周)[rad] */
+
+/* センサー位置から車軸位置への遅延 */
+constexpr float kMarkerDistanceFromCenter =            /* */
+    kLineDistanceFromCenter - kLineDistanceFromMarker; /* マーカーセンサーから車軸までの距離[m] */
+constexpr float kSensorDelayResolution = 2.0e-3f;      /* 遅延線の距離分解能[m] */
+constexpr uint32_t kSensorDelayNumPoints = 64;         /* 遅延線の点数(2の累乗) */
+constexpr uint32_t kSensorEventDelayNumPoints = 8;     /* イベント遅延線の点数(2の累乗) */
+
+/* 曲率フィードフォワード */
+constexpr float kCurvatureFeedForwardOffset = kLineDistanceFromCenter; /* 先読み距離(センサー位置で曲率を合わせる)[m] */
+constexpr float kCurvatureFeedForwardDelay = 5.0e-3f;                 /* 指令から旋回までの遅れ[s] */
+constexpr float kCurvatureFeedForwardWindow = 0.03f;                  /* 曲率を平均する区間長[m] */
+
+/* 加減速の躍度制限 (台形の目標速度を移動平均してS字にする) */
+constexpr uint32_t kVelocitySmoothingNumPoints = 16; /* 移動平均の点数(2の累乗, 躍度=加速度/(点数×周期)) */
+constexpr float kVelocitySmoothingDelay =
+    kVelocitySmoothingNumPoints * kPeriodicNotifyInterval / 2.0f; /* 移動平均による遅れ[s] */
+
+/* 吸引ファンの区間スケジュール */
+constexpr float kSuctionFullAcceleration = 15.0f; /* 吸引電圧を最大にする加速度(横・前後の合成)[m/ss] */
+constexpr float kSuctionLeadTime = 0.15f;         /* ファンの立ち上がりを見込んで先行させる時間[s] */
+
+/* 横方向の状態フィードバック */
+constexpr float kLateralNaturalFrequency = 8.0f; /* 距離領域の固有角周波数[rad/m] */
+constexpr float kLateralDampingRatio = 0.8f;     /* 減衰比 */
+constexpr float kLateralSensorNoise = 2.0e-3f;   /* 横ずれ観測ノイズ[m] */
+constexpr float kLateralSlipNoise = 0.05f;       /* 横滑り速度の変動[m/s] */
+constexpr float kLateralYawRateNoise = 0.5f;     /* 角速度の変動[rad/s] */
+
+/* ラインセンサーエラーから横ずれへの換算の同定 (ラインに沿って置き、その場旋回でセンサーを横に振る) */
+/* 車軸がライン上なら、旋回角 ψ でセンサー位置の横ずれは kLineDistanceFromCenter × tan ψ */
+constexpr float kLineOffsetIdentAngle = 0.2f;        /* 片側に振る角度[rad] */
+constexpr float kLineOffsetIdentVelocity = 0.5f;     /* 旋回速度[rad/s] */
+constexpr float kLineOffsetIdentAcceleration = 5.0f; /* 旋回加速度[rad/ss] */
+constexpr uint32_t kLineOffsetIdentMinSamples = 200; /* 同定に必要なサンプル数 */
+constexpr float kLineOffsetIdentMaxGain = 0.1f;      /* 換算の上限 (これを超えたら失敗)[m] */
+
+/* コースアウト復帰 (ラインを延長した経路へ戻す) */
+constexpr float kCourseOutRecoveryVelocity = 0.5f;      /* 復帰中の速度[m/s] */
+constexpr float kCourseOutRecoveryDeceleration = 10.0f; /* 復帰中の速度までの減速度[m/ss] */
+constexpr float kCourseOutRecoveryDistance = 0.3f;      /* ラインを最後に見た位置から停止までの距離[m] */
+constexpr float kCourseOutRecoveryMaxCurvature = 10.0f; /* 延長する経路の曲率上限[1/m] */
+
 /* ライン記憶 */
 constexpr float kMappingLimitLength = 65.0f;                       /* 最大コース記憶距離[m] */
 constexpr float kMappingDistance = 0.01f;                          /* 曲率マップ解像度[m] */
@@ -70,9 +204,18 @@ constexpr uint32_t kMappingMaxPoints =                             /*  */
 constexpr float kMappingMaxRadius = 5.0f;                          /* 最大曲率半径[m] */
 constexpr float kMappingMinAngle = 0.00001f;                       /* 最小角度[rad] */
 
+/* 電圧を考慮した加速度制限 */
+constexpr float kPlanningVoltageRatio = 0.8f; /* 加速計画に使う電圧の割合(残りはサーボの余裕) */
+constexpr float kBackEmfPerVelocity =         /* 機体速度あたりの逆起電力[V/(m/s)] */
+    kMotorBackEmf * 60.0f / (2.0f * static_cast<float>(M_PI)) * kGearRatio / kWheelRadius;
+constexpr float kForcePerCurrent = /* 両輪に同じ電流を流したときの電流あたりの加速度[m/ss/A] */
+    2.0f * kTorqueConstant * kGearRatio / (kWheelRadius * kMachineWeight);
+
 /* 位置補正 */
 constexpr float kCorrectionAllowErrorCurvature = 0.1f; /* 曲率補正許容誤差 [m] */
 constexpr float kCorrectionAllowErrorCrossLine = 0.1f; /* 交差補正許容誤差 [m] */
+constexpr float kCorrectionGoalWindow = 0.3f;          /* 最短でゴールマーカーを受け付けるゴール手前の距離 [m] */
+constexpr float kCorrectionGoalWindowGrowth = 0.02f;   /* 最後の補正からの距離に対してゴール手前の距離を広げる割合 */
 constexpr uint32_t kCorrectionMaxPoints =              /* */
     static_cast<uint32_t>(kMappingLimitLength / 0.1);  /* 補正点記憶数(コース最大距離/10cm) */
 
@@ -104,5 +247,6 @@ constexpr UBaseType_t kPriorityMotionSensing = kPriorityHigh;       /* 動作計
 constexpr UBaseType_t kPriorityMotionPlaning = kPriorityHigh;       /* 動作計画 */
 constexpr UBaseType_t kPriorityPeriodic = kPriorityRealtime;        /* 1ms通知 */
 constexpr UBaseType_t kPriorityPowerMonitoring = kPriorityRealtime; /* 電力監視 */
+constexpr UBaseType_t kPriorityFaultManager = kPriorityRealtime;    /* フォールト管理 */
 
 #endif  // APP_CONFIG_H_
@@ -0,0 +1,49 @@
+#ifndef DATA_COMPENSATEDSUM_H_
+#define DATA_COMPENSATEDSUM_H_
+
+/* C++ */
+#include <cmath>
+
+/* 丸め誤差を補償する積算 (Kahan-Babuska/Neumaier) */
+/* 大きな積算値に小さな値を足し続けても桁落ちが蓄積しない */
+template <typename T>
+class CompensatedSum {
+ public:
+  CompensatedSum() = default;
+  explicit CompensatedSum(T value) { Reset(value); }
+
+  /* 値を設定して補償項をクリア */
+  void Reset(T value = static_cast<T>(0)) {
+    sum_ = value;
+    compensation_ = static_cast<T>(0);
+  }
+
+  /* 加算 */
+  void Add(T value) {
+    T t = sum_ + value;
+    if (std::abs(sum_) >= std::abs(value)) {
+      compensation_ += (sum_ - t) + value;
+    } else {
+      compensation_ += (value - t) + sum_;
+    }
+    sum_ = t;
+  }
+
+  /* 積算値を取得 */
+  T Get() const { return sum_ + compensation_; }
+
+  CompensatedSum &operator+=(T value) {
+    Add(value);
+    return *this;
+  }
+  CompensatedSum &operator=(T value) {
+    Reset(value);
+    return *this;
+  }
+
+ private:
+  T sum_{};          /* 積算値 */
+  T compensation_{}; /* 失われた下位桁 */
+};
+
+#endif  // DATA_COMPENSATEDSUM_H_
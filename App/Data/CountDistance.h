@@ -0,0 +1,47 @@
+#ifndef DATA_COUNTDISTANCE_H_
+#define DATA_COUNTDISTANCE_H_
+
+/* C++ */
+#include <cmath>
+#include <cstdint>
+
+/* エンコーダーカウントの整数和から距離を求める */
+/* 距離は毎回 総カウント × 1カウントあたりの距離 で求めるので、走行距離が伸びても丸め誤差が蓄積しない */
+class CountDistance {
+ public:
+  explicit CountDistance(double distancePerCount) : distancePerCount_(distancePerCount) {}
+
+  /* リセット */
+  void Reset() {
+    count_ = 0;
+    residual_ = 0.0;
+  }
+
+  /* カウントを加算 */
+  void Add(int32_t count) { count_ += count; }
+
+  /* 推定した距離をカウントに換算して加算し、加算したカウントを返す (端数は次回に繰り越す) */
+  int32_t AddDistance(float distance) {
+    double counts = residual_ + static_cast<double>(distance) / distancePerCount_;
+    auto count = static_cast<int32_t>(std::lround(counts));
+    residual_ = counts - static_cast<double>(count);
+    count_ += count;
+    return count;
+  }
+
+  /* 総カウントを取得 */
+  int64_t GetCount() const { return count_; }
+
+  /* 距離を取得 [m] */
+  float Get() const { return ToDistance(count_); }
+
+  /* カウントを距離に変換 [m] */
+  float ToDistance(int64_t count) const { return static_cast<float>(static_cast<double>(count) * distancePerCount_); }
+
+ private:
+  double distancePerCount_; /* 1カウントあたりの距離 [m] */
+  int64_t count_{0};        /* 総カウント */
+  double residual_{0.0};    /* 推定距離の1カウント未満の端数 */
+};
+
+#endif  // DATA_COUNTDISTANCE_H_
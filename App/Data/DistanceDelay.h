@@ -0,0 +1,56 @@
+#ifndef DATA_DISTANCEDELAY_H_
+#define DATA_DISTANCEDELAY_H_
+
+/* C++ */
+#include <cstddef>
+
+/* Project */
+#include "Data/RingBuffer.h"
+
+/* 距離で遅らせる遅延線 */
+/* センサーで得た値をコース上の位置と組で保持し、車軸がその位置に到達したときに取り出す */
+template <typename T, std::size_t N>
+class DistanceDelay {
+ public:
+  /* リセット */
+  void Reset() { buffer_.Reset(); }
+
+  /* 値を追加 */
+  void Push(float position, /* 値を得たコース上の位置 [m] */
+            const T &value,
+            float resolution = 0.0f /* 直前の値からこの距離未満なら上書き [m] */
+  ) {
+    Entry entry{position, value};
+    std::size_t size = buffer_.Size();
+    if (size > 0 && position - buffer_[size - 1].position < resolution) {
+      buffer_[size - 1] = entry;
+      return;
+    }
+    if (size == N) {
+      /* 溢れた場合は最も古い値を捨てる */
+      buffer_.PopFront();
+    }
+    buffer_.PushBack(entry);
+  }
+
+  /* 車軸位置までに到達した値を取り出す (複数ある場合は最新の値、到達した値がなければ false) */
+  bool Pop(float position, /* 車軸位置 [m] */
+           T &value) {
+    bool reached = false;
+    while (buffer_.Size() > 0 && buffer_[0].position <= position) {
+      value = buffer_[0].value;
+      buffer_.PopFront();
+      reached = true;
+    }
+    return reached;
+  }
+
+ private:
+  struct Entry {
+    float position; /* コース上の位置 [m] */
+    T value;        /* 値 */
+  };
+  RingBuffer<Entry, N> buffer_;
+};
+
+#endif  // DATA_DISTANCEDELAY_H_
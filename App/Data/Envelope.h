@@ -0,0 +1,65 @@
+#ifndef DATA_ENVELOPE_H_
+#define DATA_ENVELOPE_H_
+
+/* C++ */
+#include <algorithm>
+
+/* Project */
+#include "Config.h"
+
+/* センサー値の下限(背景)・上限(ライン・マーカー)を走行距離の時定数でゆっくり追従する */
+/* 追従できる範囲はキャリブレーション値を基準に制限し、誤った分類で暴走しないようにする */
+template <typename T>
+class Envelope {
+ public:
+  /* キャリブレーション値でリセット */
+  void Reset(T floor, T ceiling, T maxValue /* センサーの最大値 */) {
+    floor_ = floor;
+    ceiling_ = ceiling;
+    calibratedFloor_ = floor;
+    calibratedCeiling_ = ceiling;
+    maxValue_ = maxValue;
+  }
+
+  /* 下限を追従 */
+  void UpdateFloor(T value, T ratio /* 追従の割合 (進んだ距離 / 時定数) */) {
+    floor_ += (value - floor_) * std::min(ratio, static_cast<T>(1));
+    floor_ = std::clamp(floor_, static_cast<T>(0), std::max(ceiling_ - MinContrast(), static_cast<T>(0)));
+  }
+
+  /* 上限を追従 */
+  void UpdateCeiling(T value, T ratio /* 追従の割合 (進んだ距離 / 時定数) */) {
+    ceiling_ += (value - ceiling_) * std::min(ratio, static_cast<T>(1));
+    ceiling_ = std::clamp(ceiling_, calibratedCeiling_ * static_cast<T>(kSensorEnvelopeMinRatio),
+                          std::min(calibratedCeiling_ * static_cast<T>(kSensorEnvelopeMaxRatio), maxValue_));
+    floor_ = std::min(floor_, std::max(ceiling_ - MinContrast(), static_cast<T>(0)));
+  }
+
+  /* 下限を取得 */
+  T GetFloor() const { return floor_; }
+  /* 上限を取得 */
+  T GetCeiling() const { return ceiling_; }
+
+  /* 下限と上限の間で割合 ratio の値を取得 (しきい値) */
+  T GetThreshold(T ratio) const { return floor_ + (ceiling_ - floor_) * ratio; }
+
+  /* 下限0・上限1に正規化 */
+  T Normalize(T value) const { return (std::clamp(value, floor_, ceiling_) - floor_) / (ceiling_ - floor_); }
+  /* 正規化した値を下限・上限の範囲の値に戻す */
+  T Denormalize(T normalized) const { return floor_ + (ceiling_ - floor_) * normalized; }
+
+ private:
+  T floor_{0};
+  T ceiling_{1};
+  T calibratedFloor_{0};
+  T calibratedCeiling_{1};
+  T maxValue_{1};
+
+  /* 下限と上限の最小の差 (キャリブレーション時の差に対する割合) */
+  T MinContrast() const {
+    return std::max((calibratedCeiling_ - calibratedFloor_) * static_cast<T>(kSensorEnvelopeMinContrast),
+                    static_cast<T>(1));
+  }
+};
+
+#endif  // DATA_ENVELOPE_H_
@@ -0,0 +1,48 @@
+#ifndef DATA_GAINSCHEDULE_H_
+#define DATA_GAINSCHEDULE_H_
+
+/* C++ */
+#include <cstddef>
+
+/* 速度で線形補間するゲインテーブル (集成体なので定数として初期化でき、参照時に確保しない) */
+template <typename Gain, std::size_t N>
+struct GainSchedule {
+  static_assert(N > 0, "N must be positive");
+
+  struct Point {
+    float speed; /* 速度 [m/s] (昇順) */
+    Gain gain;   /* ゲイン */
+  };
+  Point points[N];
+
+  /* 速度によらず一定のゲイン */
+  static constexpr GainSchedule Constant(const Gain &gain) {
+    GainSchedule schedule{};
+    for (auto &point : schedule.points) {
+      point = {0.0f, gain};
+    }
+    return schedule;
+  }
+
+  /* 速度に対応するゲインを取得 (範囲外は端の値) */
+  Gain Get(float speed) const {
+    if (speed <= points[0].speed) {
+      return points[0].gain;
+    }
+    for (std::size_t i = 1; i < N; i++) {
+      const auto &lower = points[i - 1];
+      const auto &upper = points[i];
+      if (speed < upper.speed) {
+        float ratio = (speed - lower.speed) / (upper.speed - lower.speed);
+        Gain gain = lower.gain;
+        for (std::size_t j = 0; j < gain.size(); j++) {
+          gain[j] += ratio * (upper.gain[j] - lower.gain[j]);
+        }
+        return gain;
+      }
+    }
+    return points[N - 1].gain;
+  }
+};
+
+#endif  // DATA_GAINSCHEDULE_H_
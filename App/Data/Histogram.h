@@ -0,0 +1,54 @@
+#ifndef DATA_HISTOGRAM_H_
+#define DATA_HISTOGRAM_H_
+
+/* C++ */
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+/* 0 ~ kMaxValue の整数値のヒストグラム (外れ値に強い分位点を求める) */
+/* 度数は uint16_t で数え、あふれるビンに入る値は以後数えない */
+template <uint32_t kNumBins, uint32_t kMaxValue>
+class Histogram {
+ public:
+  static_assert((kMaxValue + 1) % kNumBins == 0, "kNumBins must divide kMaxValue + 1");
+  static constexpr uint32_t kBinWidth = (kMaxValue + 1) / kNumBins;
+
+  /* リセット */
+  void Reset() {
+    bins_.fill(0);
+    count_ = 0;
+  }
+
+  /* 値を追加 */
+  void Add(uint32_t value) {
+    uint32_t bin = std::min(value, kMaxValue) / kBinWidth;
+    if (bins_[bin] < UINT16_MAX) {
+      bins_[bin]++;
+      count_++;
+    }
+  }
+
+  /* 度数の合計を取得 */
+  uint32_t GetCount() const { return count_; }
+
+  /* 下から割合 ratio の位置の値を取得 (ビンの中は一様に分布しているとして補間) */
+  float GetPercentile(float ratio) const {
+    float rank = std::clamp(ratio, 0.0f, 1.0f) * static_cast<float>(count_);
+    uint32_t cumulative = 0;
+    for (uint32_t bin = 0; bin < kNumBins; bin++) {
+      if (bins_[bin] > 0 && static_cast<float>(cumulative + bins_[bin]) >= rank) {
+        float fraction = (rank - static_cast<float>(cumulative)) / static_cast<float>(bins_[bin]);
+        return (static_cast<float>(bin) + std::max(fraction, 0.0f)) * static_cast<float>(kBinWidth);
+      }
+      cumulative += bins_[bin];
+    }
+    return static_cast<float>(kMaxValue);
+  }
+
+ private:
+  std::array<uint16_t, kNumBins> bins_{};
+  uint32_t count_{0};
+};
+
+#endif  // DATA_HISTOGRAM_H_
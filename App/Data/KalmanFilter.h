@@ -0,0 +1,68 @@
+#ifndef DATA_KALMANFILTER_H_
+#define DATA_KALMANFILTER_H_
+
+/* C++ */
+#include <array>
+
+/* 2状態の線形カルマンフィルタ (観測はスカラーで逐次更新するので逆行列が不要) */
+template <typename T>
+class KalmanFilter2 {
+ public:
+  using Vector = std::array<T, 2>;
+  using Matrix = std::array<Vector, 2>;
+
+  /* 状態と誤差共分散を初期化 */
+  void Reset(const Vector &x, const Matrix &p) {
+    x_ = x;
+    p_ = p;
+  }
+
+  /* 状態を取得 */
+  const Vector &Get() const { return x_; }
+
+  /* 予測 (x = F x + u, P = F P F^T + Q) */
+  void Predict(const Matrix &f, const Vector &u, const Matrix &q) {
+    Vector x{};
+    Matrix fp{};
+    for (int i = 0; i < 2; i++) {
+      x[i] = f[i][0] * x_[0] + f[i][1] * x_[1] + u[i];
+      for (int j = 0; j < 2; j++) {
+        fp[i][j] = f[i][0] * p_[0][j] + f[i][1] * p_[1][j];
+      }
+    }
+    for (int i = 0; i < 2; i++) {
+      for (int j = 0; j < 2; j++) {
+        p_[i][j] = fp[i][0] * f[j][0] + fp[i][1] * f[j][1] + q[i][j];
+      }
+    }
+    x_ = x;
+  }
+
+  /* 観測で更新 (z = h x + v, v の分散 r) */
+  void Correct(const Vector &h, T z, T r) {
+    /* P h^T */
+    Vector ph = {p_[0][0] * h[0] + p_[0][1] * h[1], p_[1][0] * h[0] + p_[1][1] * h[1]};
+    /* イノベーション分散 */
+    T s = h[0] * ph[0] + h[1] * ph[1] + r;
+    if (s <= static_cast<T>(0)) [[unlikely]] {
+      return;
+    }
+    /* カルマンゲイン */
+    Vector k = {ph[0] / s, ph[1] / s};
+    T innovation = z - (h[0] * x_[0] + h[1] * x_[1]);
+    x_[0] += k[0] * innovation;
+    x_[1] += k[1] * innovation;
+    /* P = P - K (P h^T)^T */
+    for (int i = 0; i < 2; i++) {
+      for (int j = 0; j < 2; j++) {
+        p_[i][j] -= k[i] * ph[j];
+      }
+    }
+  }
+
+ private:
+  Vector x_{}; /* 状態 */
+  Matrix p_{}; /* 誤差共分散 */
+};
+
+#endif  // DATA_KALMANFILTER_H_
@@ -0,0 +1,42 @@
+#ifndef DATA_LINEARFIT_H_
+#define DATA_LINEARFIT_H_
+
+/* C++ */
+#include <cstdint>
+
+/* y = a x + b の最小二乗直線 (和だけを持つので点数によらずメモリ一定) */
+class LinearFit {
+ public:
+  /* リセット */
+  void Reset() { n_ = 0, sx_ = 0.0, sy_ = 0.0, sxx_ = 0.0, sxy_ = 0.0; }
+
+  /* 点を追加 */
+  void Add(float x, float y) {
+    n_++;
+    sx_ += x;
+    sy_ += y;
+    sxx_ += static_cast<double>(x) * x;
+    sxy_ += static_cast<double>(x) * y;
+  }
+
+  /* 点数を取得 */
+  uint32_t GetCount() const { return n_; }
+
+  /* 傾きと切片を取得 (x がばらついていなければ false) */
+  bool Get(float &slope, float &intercept) const {
+    double n = static_cast<double>(n_);
+    double denominator = n * sxx_ - sx_ * sx_;
+    if (n_ < 2 || denominator <= 0.0) {
+      return false;
+    }
+    slope = static_cast<float>((n * sxy_ - sx_ * sy_) / denominator);
+    intercept = static_cast<float>((sy_ - slope * sx_) / n);
+    return true;
+  }
+
+ private:
+  uint32_t n_{0};
+  double sx_{0.0}, sy_{0.0}, sxx_{0.0}, sxy_{0.0};
+};
+
+#endif  // DATA_LINEARFIT_H_
@@ -2,49 +2,120 @@
 #define DATA_PID_H_
 
 /* C++ */
+#include <algorithm>
 #include <array>
+#include <limits>
 
-class Pid {
+/* Project */
+#include "Config.h"
+#include "Data/GainSchedule.h"
+
+/* 固定周期のPID制御 */
+/* 周期 kStep [s] をコンパイル時に固定し、ゲイン設定時に離散化係数を前計算して毎周期の除算をなくす */
+template <typename T, T kStep>
+class BasicPid {
  public:
-  using Gain = std::array<float, 3>;
+  static_assert(kStep > static_cast<T>(0), "kStep must be positive");
+
+  using Gain = std::array<T, 3>; /* Kp, Ki [1/s], Kd [s] */
 
   void Reset(const Gain &gain) {
-    gainKp_ = gain[0];
-    gainKi_ = gain[1];
-    gainKd_ = gain[2];
+    gain_ = gain;
+    Precompute();
     Reset();
   }
+  /* ゲインのみ変更 (積分項は積分後の値を保持するのでゲインが変わっても出力が跳ねない) */
+  void SetGain(const Gain &gain) {
+    gain_ = gain;
+    Precompute();
+  }
   void Reset() {
-    prevError_ = 0.0f;
-    sumError_ = 0.0f;
+    prevError_ = static_cast<T>(0);
+    prevDerivativeError_ = static_cast<T>(0);
+    p_ = static_cast<T>(0);
+    i_ = static_cast<T>(0);
+    d_ = static_cast<T>(0);
+    output_ = static_cast<T>(0);
   }
 
-  float Get() { return p_ + i_ + d_; }
-  float GetProportional() { return p_; }
-  float GetIntegral() { return i_; }
-  float GetDerivative() { return d_; }
+  /* 出力制限 (積分項も同じ範囲に制限する) */
+  void SetLimit(T min, T max) {
+    outputMin_ = min;
+    outputMax_ = max;
+  }
+  /* 微分項の一次フィルタ時定数 [s] (0でフィルタなし) */
+  void SetDerivativeFilter(T timeConstant) {
+    derivativeTimeConstant_ = std::max(timeConstant, static_cast<T>(0));
+    Precompute();
+  }
+  /* 目標値の重み (比例項 b, 微分項 c) */
+  void SetSetpointWeight(T proportional, T derivative) {
+    proportionalWeight_ = proportional;
+    derivativeWeight_ = derivative;
+  }
+  /* バックカリキュレーションのゲイン [1/s] (0なら飽和中に積分を止める) */
+  void SetTrackingGain(T gain) { tracking_ = gain * kStep; }
 
-  float Update(float target, float current, float t) {
-    float error = target - current;
-    sumError_ += (error + prevError_) * t / 2.0f;
-    p_ = gainKp_ * error;
-    i_ = gainKi_ * sumError_;
-    d_ = gainKd_ * (error - prevError_) / t;
+  T Get() const { return output_; }
+  T GetProportional() const { return p_; }
+  T GetIntegral() const { return i_; }
+  T GetDerivative() const { return d_; }
+
+  T Update(T target, T current) {
+    T error = target - current;
+    T derivativeError = derivativeWeight_ * target - current;
+    p_ = gain_[0] * (proportionalWeight_ * target - current);
+    /* 後退オイラーで離散化した一次フィルタ付き微分 */
+    d_ = derivativeDecay_ * d_ + derivativeGain_ * (derivativeError - prevDerivativeError_);
+    /* 台形積分 */
+    T integral = i_ + integralGain_ * (error + prevError_);
+    T output = p_ + integral + d_;
+    output_ = std::clamp(output, outputMin_, outputMax_);
+    if (tracking_ > static_cast<T>(0)) {
+      /* 飽和分を積分に戻す */
+      integral += tracking_ * (output_ - output);
+    } else if (output != output_ && (output - output_) * error > static_cast<T>(0)) {
+      /* 飽和を深める方向には積分しない */
+      integral = i_;
+    }
+    i_ = std::clamp(integral, outputMin_, outputMax_);
     prevError_ = error;
-    return p_ + i_ + d_;
+    prevDerivativeError_ = derivativeError;
+    return output_;
   }
 
  private:
-  float gainKp_{};
-  float gainKi_{};
-  float gainKd_{};
+  Gain gain_{};
+  T outputMin_{std::numeric_limits<T>::lowest()};
+  T outputMax_{std::numeric_limits<T>::max()};
+  T derivativeTimeConstant_{};
+  T proportionalWeight_{1};
+  T derivativeWeight_{1};
+  T tracking_{};
+
+  /* 前計算した離散化係数 */
+  T integralGain_{};
+  T derivativeGain_{};
+  T derivativeDecay_{};
+
+  T p_{};
+  T i_{};
+  T d_{};
+  T output_{};
 
-  float p_{};
-  float i_{};
-  float d_{};
+  T prevError_{};
+  T prevDerivativeError_{};
 
-  float prevError_{};
-  float sumError_{};
+  void Precompute() {
+    integralGain_ = gain_[1] * kStep / static_cast<T>(2);
+    derivativeGain_ = gain_[2] / (derivativeTimeConstant_ + kStep);
+    derivativeDecay_ = derivativeTimeConstant_ / (derivativeTimeConstant_ + kStep);
+  }
 };
 
+/* 周期タスク用PID */
+using Pid = BasicPid<float, kPeriodicNotifyInterval>;
+/* 周期タスク用PIDの速度スケジュール */
+using PidGainSchedule = GainSchedule<Pid::Gain, kGainScheduleNumPoints>;
+
 #endif  // DATA_PID_H_
@@ -0,0 +1,176 @@
+#include "FaultManager.h"
+
+/* STM32CubeMX */
+#include <main.h>
+
+/* FreeRTOS */
+#include <task.h>
+
+/* C++ */
+#include <algorithm>
+#include <array>
+#include <cstdio>
+
+/* Project */
+#include "Config.h"
+#include "MotionPlaning/Motor.h"
+#include "NonVolatileData.h"
+
+namespace {
+/* 要因と対応・表示名の対応表 */
+struct FaultPolicy {
+  FaultCode code;
+  FaultReaction reaction;
+  const char *name;
+};
+constexpr std::array<FaultPolicy, 8> kFaultPolicies = {{
+    {FaultCode::kMotorDriver, FaultReaction::kCutOff, "MotorDriver"},
+    {FaultCode::kServoInvalid, FaultReaction::kCutOff, "ServoInvalid"},
+    {FaultCode::kServoLinear, FaultReaction::kStop, "ServoLinear"},
+    {FaultCode::kServoAngular, FaultReaction::kStop, "ServoAngular"},
+    {FaultCode::kLineLost, FaultReaction::kStop, "LineLost"},
+    {FaultCode::kBattery, FaultReaction::kReset, "Battery"},
+    {FaultCode::kPowerAdc, FaultReaction::kReset, "PowerAdc"},
+    {FaultCode::kCurrentLoop, FaultReaction::kCutOff, "CurrentLoop"},
+}};
+}  // namespace
+
+/* nFAULTの外部割り込み (HALの弱シンボルを上書き) */
+extern "C" void HAL_GPIO_EXTI_Callback(uint16_t pin) {
+  if (pin == DRV_NFAULT_Pin) {
+    FaultManager::OnDriverFault();
+  }
+}
+
+/* 初期化 */
+bool FaultManager::Initialize() {
+  /* nFAULT(オープンドレイン、Lowでフォールト)の立ち下がりで割り込む */
+  GPIO_InitTypeDef init = {};
+  init.Pin = DRV_NFAULT_Pin;
+  init.Mode = GPIO_MODE_IT_FALLING;
+  init.Pull = GPIO_PULLUP;
+  HAL_GPIO_Init(DRV_NFAULT_GPIO_Port, &init);
+  /* FreeRTOSのAPIを呼ぶので、システムコールを許可する優先度以下にする */
+  HAL_NVIC_SetPriority(EXTI9_5_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(EXTI9_5_IRQn);
+  return TaskCreate("FaultManager", configMINIMAL_STACK_SIZE, kPriorityFaultManager);
+}
+
+/* フォールトを通知 */
+void FaultManager::Raise(FaultCode code) {
+  uint32_t bit = static_cast<uint32_t>(code);
+  bool isr = xPortIsInsideInterrupt();
+  UBaseType_t status = 0;
+  if (isr) {
+    status = taskENTER_CRITICAL_FROM_ISR();
+  } else {
+    taskENTER_CRITICAL();
+  }
+  bool raised = (latched_ & bit) == 0;
+  latched_ = latched_ | bit;
+  if (raised) {
+    pending_ = pending_ | bit;
+  }
+  if (isr) {
+    taskEXIT_CRITICAL_FROM_ISR(status);
+  } else {
+    taskEXIT_CRITICAL();
+  }
+  if (!raised) {
+    return; /* ラッチ済み */
+  }
+
+  /* 遮断以上はタスクを待たずにこの場でドライバを止める */
+  if (GetReaction(code) != FaultReaction::kStop) {
+    auto &motor = MotionPlaning::Motor::Instance();
+    motor.Brake();
+    motor.Disable();
+  }
+
+  /* 履歴の書き込みとリセットはタスクで行う */
+  if (TaskHandle() == nullptr) {
+    return;
+  }
+  if (isr) {
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    xTaskNotifyFromISR(TaskHandle(), kTaskNotifyBitFault, eSetBits, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+  } else {
+    xTaskNotify(TaskHandle(), kTaskNotifyBitFault, eSetBits);
+  }
+}
+
+/* ラッチを解除 */
+void FaultManager::Clear() {
+  taskENTER_CRITICAL();
+  latched_ = 0;
+  taskEXIT_CRITICAL();
+}
+
+/* 要因に対する対応を取得 */
+FaultReaction FaultManager::GetReaction(FaultCode code) {
+  for (const auto &policy : kFaultPolicies) {
+    if (policy.code == code) {
+      return policy.reaction;
+    }
+  }
+  return FaultReaction::kStop;
+}
+
+/* nFAULTの立ち下がりによる通知 */
+void FaultManager::OnDriverFault() {
+  /* スリープ中(DRV_EN=Low)のnFAULTは意味を持たないので無視 */
+  if (!MotionPlaning::Motor::Instance().IsEnabled()) {
+    return;
+  }
+  Instance().Raise(FaultCode::kMotorDriver);
+}
+
+/* 履歴を表示 */
+void FaultManager::PrintHistory(uint32_t maxRecords) {
+  std::array<uint32_t, kFaultHistoryNumRecords> tick{};
+  std::array<uint32_t, kFaultHistoryNumRecords> code{};
+  uint32_t count = 0;
+  if (!NonVolatileData::ReadFaultHistoryData(tick, code, count)) {
+    printf("Fault history: read error\r\n");
+    return;
+  }
+  printf("Fault history: %ld\r\n", count);
+  uint32_t num = std::min({count, maxRecords, kFaultHistoryNumRecords});
+  for (uint32_t i = 0; i < num; i++) {
+    uint32_t index = (count - 1 - i) % kFaultHistoryNumRecords;
+    printf("  #%ld %ld ms:", count - i, tick[index]);
+    for (const auto &policy : kFaultPolicies) {
+      if (code[index] & static_cast<uint32_t>(policy.code)) {
+        printf(" %s", policy.name);
+      }
+    }
+    printf("\r\n");
+  }
+}
+
+/* タスク */
+void FaultManager::TaskEntry() {
+  uint32_t notify = 0;
+  while (true) {
+    if (!TaskNotifyWait(notify)) {
+      continue;
+    }
+    if (notify & kTaskNotifyBitFault) {
+      taskENTER_CRITICAL();
+      uint32_t pending = pending_;
+      pending_ = 0;
+      taskEXIT_CRITICAL();
+      if (pending == 0) {
+        continue;
+      }
+      /* 同時に上がった要因はまとめて1件に記録 */
+      NonVolatileData::AppendFaultHistoryData(xTaskGetTickCount(), pending);
+      for (const auto &policy : kFaultPolicies) {
+        if ((pending & static_cast<uint32_t>(policy.code)) && policy.reaction == FaultReaction::kReset) {
+          NVIC_SystemReset();
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,67 @@
+#ifndef APP_FAULTMANAGER_H_
+#define APP_FAULTMANAGER_H_
+
+/* Project */
+#include "Wrapper/Task.h"
+
+/* C++ */
+#include <cstdint>
+
+/* フォールト要因 (ラッチはビットの論理和で保持する) */
+enum class FaultCode : uint32_t {
+  kMotorDriver = (0x01 << 0),  /* モータードライバのnFAULT (過電流・過熱・低電圧) */
+  kServoInvalid = (0x01 << 1), /* 電圧指令がNaN・Inf */
+  kServoLinear = (0x01 << 2),  /* 並進速度が指令に追従しない */
+  kServoAngular = (0x01 << 3), /* 旋回速度が指令に追従しない */
+  kLineLost = (0x01 << 4),     /* ラインが見えない */
+  kBattery = (0x01 << 5),      /* バッテリー電圧が下限以下 */
+  kPowerAdc = (0x01 << 6),     /* 電源ADCの取得失敗 */
+  kCurrentLoop = (0x01 << 7),  /* 電流制御の割り込みが止まった */
+};
+
+/* フォールト時の対応 (後ろほど重い) */
+enum class FaultReaction {
+  kStop,   /* 次の制御周期で走行を止める */
+  kCutOff, /* 通知した場で(割り込み内でも)ドライバを遮断する */
+  kReset,  /* ドライバを遮断し、履歴を書き込んでからリセットする */
+};
+
+/* フォールト管理 */
+/* 各所で検出したフォールトをラッチし、要因ごとに決めた対応をとって履歴をFRAMに残す */
+/* ラッチはモーターを再び有効にするとき(MotionPlaningの開始時)に解除する */
+class FaultManager final : public Task<FaultManager> {
+ public:
+  /* 初期化 (nFAULTの外部割り込みを有効にする) */
+  bool Initialize();
+
+  /* フォールトを通知 (割り込みからも呼べる) */
+  void Raise(FaultCode code);
+
+  /* ラッチを解除 (履歴は残る) */
+  void Clear();
+
+  /* ラッチ中のフォールトを取得 */
+  uint32_t GetLatched() const { return latched_; }
+
+  /* 走行を止める必要があるか */
+  bool IsStopRequired() const { return latched_ != 0; }
+
+  /* 要因に対する対応を取得 */
+  static FaultReaction GetReaction(FaultCode code);
+
+  /* nFAULTの立ち下がりによる通知 (外部割り込みから呼ぶ) */
+  static void OnDriverFault();
+
+  /* 履歴を表示 (新しい順) */
+  void PrintHistory(uint32_t maxRecords);
+
+ protected:
+  /* タスク */
+  void TaskEntry() final;
+
+ private:
+  volatile uint32_t latched_{0}; /* ラッチ中のフォールト */
+  volatile uint32_t pending_{0}; /* 履歴に未記録のフォールト */
+};
+
+#endif  // APP_FAULTMANAGER_H_
@@ -107,7 +107,7 @@ bool Fram::Write(uint32_t address, const void *data, uint32_t size, TickType_t x
   if (address + size > kMaxAddress) {
     return false;
   }
-  if (Send(request, xTicksToWait) && Receive(response, xTicksToWait)) {
+  if (Transact(request, response, xTicksToWait)) {
     return response == FramResponse::kSuccess;
   }
   return false;
@@ -120,7 +120,7 @@ bool Fram::Read(uint32_t address, void *data, uint32_t size, TickType_t xTicksTo
   if (address + size > kMaxAddress) {
     return false;
   }
-  if (Send(request, xTicksToWait) && Receive(response, xTicksToWait)) {
+  if (Transact(request, response, xTicksToWait)) {
     return response == FramResponse::kSuccess;
   }
   return false;
@@ -130,7 +130,7 @@ bool Fram::Clear() {
   FramRequest request = {FramRequest::Type::kClear, 0, nullptr, nullptr, 0};
   FramResponse response = {};
 
-  if (Send(request) && Receive(response)) {
+  if (Transact(request, response)) {
     return response == FramResponse::kSuccess;
   }
   return false;
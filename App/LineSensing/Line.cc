@@ -2,6 +2,7 @@
 
 /* C++ */
 #include <cmath>
+#include <cstdio>
 #include <cstring>
 #include <mutex>
 
@@ -88,7 +89,20 @@ bool LineAdc::Fetch() {
 void LineImpl::Reset() {
   std::scoped_lock<Mutex> lock(mtx_);
   state_ = State::kNormal;
+  /* 走行ごとにキャリブレーション値から追従し直す */
+  for (uint32_t order = 0; order < kNum; order++) {
+    envelope_[order].Reset(min_[order], max_[order], LineAdc::kAdcMaxValue);
+  }
+  envelopeDistance_ = 0.0f;
+  /* 健全性は保持し、固着判定の区間だけやり直す */
+  windowMin_.fill(UINT16_MAX);
+  windowMax_.fill(0);
+  healthDistance_ = 0.0f;
   errorAverage_.Reset();
+  errorDelay_.Reset();
+  crossDelay_.Reset();
+  errorAtAxle_ = 0.0f;
+  crossPassedAtAxle_ = false;
 }
 
 /* 更新 */
@@ -104,15 +118,46 @@ bool LineImpl::Update(float distance) {
   {
     std::scoped_lock<Mutex> lock(mtx_);
     /* ラインセンサーの値を補正、反応個数を計算 */
+    /* 下限・上限はキャリブレーション値から追従したものを使い、係数はその幅の変化分を補正する */
+    std::array<uint16_t, kNum> raw{};
+    std::array<float, kNum> normalized{};
     std::array<float, kNum> value{};
+    for (uint32_t order = 0; order < LineAdc::kNum; order++) {
+      raw[order] = adc.GetRaw(order);
+      normalized[order] = envelope_[order].Normalize(raw[order]);
+    }
+    /* 異常なチャンネルは推定から外し、両隣の値で置き換えて重みの偏りを防ぐ */
+    UpdateHealth(raw, normalized, distance);
+    Interpolate(normalized);
+    uint32_t peak = 0;
     detectNum_ = 0;
     for (uint32_t order = 0; order < LineAdc::kNum; order++) {
-      uint16_t val = std::clamp(adc.GetRaw(order), min_[order], max_[order]);
-      if (val > max_[order] * kLineDetectThreshold) {
+      /* 検知は従来どおり上限に対する割合で判定する (補間したチャンネルも正規化値から戻して同じく判定) */
+      const auto &envelope = envelope_[order];
+      if (envelope.Denormalize(normalized[order]) > envelope.GetCeiling() * kLineDetectThreshold) {
         detectNum_++;
       }
-      value[order] = coeff_[order] * (val - min_[order]);
+      value[order] = coeff_[order] * (max_[order] - min_[order]) * normalized[order];
+      if (normalized[order] > normalized[peak]) {
+        peak = order;
+      }
     }
+    /* 通常の追従中だけ、ライン上のセンサーで上限を、ラインから離れたセンサーで下限を追従 */
+    /* 交差・コースアウト中はどのセンサーがライン上か分からないので追従しない */
+    if (state_ == State::kNormal && detectNum_ > 0 && detectNum_ < kLineCrossDetectNum) {
+      float ratio = std::abs(distance - envelopeDistance_) / kSensorEnvelopeDistance;
+      for (uint32_t order = 0; order < LineAdc::kNum; order++) {
+        if (!IsHealthy(order)) {
+          continue;
+        }
+        if (order == peak) {
+          envelope_[order].UpdateCeiling(raw[order], ratio);
+        } else if (normalized[order] < kSensorEnvelopeClassify) {
+          envelope_[order].UpdateFloor(raw[order], ratio);
+        }
+      }
+    }
+    envelopeDistance_ = distance;
     /* ラインセンサーの値を一次元化 */
     float diff = 0.0f;
     for (uint32_t order = 0; order < 8; order++) {
@@ -144,6 +189,16 @@ bool LineImpl::Update(float distance) {
       }
       errorAverage_.Update(diff);
     }
+    /* センサー位置の値を車軸位置へ遅延 */
+    float position = distance + kLineDistanceFromCenter;
+    if (state_ == State::kNormal) {
+      errorDelay_.Push(position, errorAverage_.Get(), kSensorDelayResolution);
+    } else if (state_ == State::kCrossPassed) {
+      crossDelay_.Push(position, true);
+    }
+    bool passed = false;
+    errorDelay_.Pop(distance, errorAtAxle_);
+    crossPassedAtAxle_ = crossDelay_.Pop(distance, passed);
   }
   return true;
 }
@@ -157,6 +212,20 @@ void LineImpl::SetCalibration(const std::array<uint16_t, kNum> &min, /* 最小
   min_ = min;
   max_ = max;
   coeff_ = coeff;
+  for (uint32_t order = 0; order < kNum; order++) {
+    envelope_[order].Reset(min_[order], max_[order], LineAdc::kAdcMaxValue);
+    health_[order] = {false, false, false, 0.0f, 0};
+    windowMin_[order] = UINT16_MAX;
+    windowMax_[order] = 0;
+    lastRaw_[order] = 0;
+  }
+  healthDistance_ = 0.0f;
+}
+
+/* エラーから横ずれへの換算を設定 */
+void LineImpl::SetOffsetGain(float errorToOffset) {
+  std::scoped_lock<Mutex> lock(mtx_);
+  errorToOffset_ = std::max(errorToOffset, 0.0f);
 }
 
 /* 生値を取得 */
@@ -191,9 +260,118 @@ float LineImpl::GetError() const {
   }
 }
 
+/* 車軸位置でのエラーを取得 */
+float LineImpl::GetErrorAtAxle() const {
+  std::scoped_lock<Mutex> lock(mtx_);
+  return errorAtAxle_;
+}
+
+/* エラーから横ずれへの換算が同定済みか */
+bool LineImpl::HasOffsetGain() const { return errorToOffset_ > 0.0f; }
+
+/* センサー位置でのライン横ずれを取得 */
+/* 係数でセンサーごとに0~1へ正規化しているので、換算はキャリブレーションし直しても変わらない */
+float LineImpl::GetOffset() const { return GetError() * errorToOffset_; }
+
 /* ラインがないか */
 bool LineImpl::IsNone() const { return state_ == State::kNone; }
 
 /* 交差か */
 bool LineImpl::IsCrossPassed() const { return state_ == State::kCrossPassed; }
+
+/* 車軸が交差を通過したか */
+bool LineImpl::IsCrossPassedAtAxle() const { return crossPassedAtAxle_; }
+
+/* 健全性を取得 */
+std::array<LineImpl::Health, LineImpl::kNum> LineImpl::GetHealth() const {
+  std::scoped_lock<Mutex> lock(mtx_);
+  return health_;
+}
+
+/* 健全性を表示 */
+void LineImpl::PrintHealth() const {
+  auto health = GetHealth();
+  printf(" ----- LineSensing::LineImpl::PrintHealth ----- \r\n");
+  for (uint32_t ch = 0; ch < 16; ch++) {
+    const auto &h = health[ch];
+    printf("%s%ld Stuck: %d, LowContrast: %d, Noisy: %d, Noise: %f, Excluded: %ld\r\n", ch < 8 ? "Right" : "Left ",
+           ch % 8, h.stuck, h.lowContrast, h.noisy, static_cast<double>(h.noise), h.excluded);
+  }
+}
+
+/* 健全性を更新 */
+void LineImpl::UpdateHealth(const std::array<uint16_t, kNum> &raw, const std::array<float, kNum> &normalized,
+                            float distance) {
+  static_assert(kLineHealthMinContrast > kSensorEnvelopeMinContrast, "Envelope must be able to collapse below it");
+  /* 固着は走行距離の区間ごとに判定 (停止中は判定しない) */
+  bool windowEnd = std::abs(distance - healthDistance_) >= kLineHealthWindow;
+  for (uint32_t order = 0; order < kNum; order++) {
+    auto &health = health_[order];
+    float span = static_cast<float>(std::max(max_[order] - min_[order], 1));
+    windowMin_[order] = std::min(windowMin_[order], raw[order]);
+    windowMax_[order] = std::max(windowMax_[order], raw[order]);
+    if (windowEnd) {
+      health.stuck = windowMax_[order] - windowMin_[order] <= kLineHealthStuckRange;
+      windowMin_[order] = UINT16_MAX;
+      windowMax_[order] = 0;
+    }
+    /* 追従した下限と上限の差が潰れていないか */
+    const auto &envelope = envelope_[order];
+    health.lowContrast = envelope.GetCeiling() - envelope.GetFloor() < span * kLineHealthMinContrast;
+    /* 通常の追従中に背景を見ている間の1周期の変化量でばらつきを評価 */
+    if (state_ == State::kNormal && normalized[order] < kSensorEnvelopeClassify) {
+      float delta = std::abs(static_cast<float>(raw[order]) - static_cast<float>(lastRaw_[order])) / span;
+      health.noise += (delta - health.noise) * kLineHealthNoiseFilter;
+      health.noisy = health.noise > kLineHealthMaxNoise;
+    }
+    lastRaw_[order] = raw[order];
+    if (!IsHealthy(order)) {
+      health.excluded++;
+    }
+  }
+  if (windowEnd) {
+    healthDistance_ = distance;
+  }
+}
+
+/* 健全か */
+bool LineImpl::IsHealthy(uint32_t order) const {
+  const auto &health = health_[order];
+  return !health.stuck && !health.lowContrast && !health.noisy;
+}
+
+/* 異常なチャンネルの正規化値を並びの両隣から補間 */
+void LineImpl::Interpolate(std::array<float, kNum> &normalized) const {
+  /* 左端から右端への並び (右は 0 ~ 7 が内側から外側、左は 8 ~ 15 が内側から外側) */
+  static constexpr std::array<uint32_t, kNum> kPlacement = {15, 14, 13, 12, 11, 10, 9, 8, 0, 1, 2, 3, 4, 5, 6, 7};
+  std::array<float, kNum> source = normalized;
+  for (int32_t i = 0; i < static_cast<int32_t>(kNum); i++) {
+    if (IsHealthy(kPlacement[i])) {
+      continue;
+    }
+    /* 両側で最も近い健全なチャンネル */
+    int32_t left = i - 1;
+    while (left >= 0 && !IsHealthy(kPlacement[left])) {
+      left--;
+    }
+    int32_t right = i + 1;
+    while (right < static_cast<int32_t>(kNum) && !IsHealthy(kPlacement[right])) {
+      right++;
+    }
+    bool hasLeft = left >= 0;
+    bool hasRight = right < static_cast<int32_t>(kNum);
+    float value = 0.0f;
+    if (hasLeft && hasRight) {
+      float ratio = static_cast<float>(i - left) / static_cast<float>(right - left);
+      value = source[kPlacement[left]] + (source[kPlacement[right]] - source[kPlacement[left]]) * ratio;
+    } else if (hasLeft) {
+      value = source[kPlacement[left]];
+    } else if (hasRight) {
+      value = source[kPlacement[right]];
+    } else {
+      continue; /* 全チャンネル異常ならそのまま */
+    }
+    normalized[kPlacement[i]] = value;
+  }
+}
 }  // namespace LineSensing
@@ -14,6 +14,8 @@
 
 /* Project */
 #include "Config.h"
+#include "Data/DistanceDelay.h"
+#include "Data/Envelope.h"
 #include "Data/MovingAverage.h"
 #include "Data/Singleton.h"
 #include "Wrapper/Mutex.h"
@@ -64,6 +66,15 @@ class LineImpl {
     kCrossPassed,   /* 交差通過完了 */
   };
 
+  /* センサーの健全性 */
+  struct Health {
+    bool stuck;        /* 値が変化しない */
+    bool lowContrast;  /* 下限と上限の差が潰れた */
+    bool noisy;        /* 背景でのばらつきが大きい */
+    float noise;       /* 背景での1周期の変化量の平均 (キャリブレーション時の差に対する割合) */
+    uint32_t excluded; /* 推定から外した回数 */
+  };
+
   /* リセット */
   void Reset();
 
@@ -76,6 +87,9 @@ class LineImpl {
                       const std::array<float, kNum> &coeff   /* 係数 */
   );
 
+  /* エラーから横ずれへの換算を設定 [m] (0以下なら未同定) */
+  void SetOffsetGain(float errorToOffset);
+
   /* 生値を取得 */
   std::array<uint16_t, kNum> GetRaw() const;
 
@@ -85,27 +99,68 @@ class LineImpl {
   /* 反応センサーの個数を取得 */
   uint8_t GetDetectNum() const;
 
-  /* エラーを取得 */
+  /* エラーを取得 (センサー位置) */
   float GetError() const;
 
+  /* 車軸位置でのエラーを取得 (センサーが車軸の現在位置で得たエラー) */
+  float GetErrorAtAxle() const;
+
+  /* エラーから横ずれへの換算が同定済みか */
+  bool HasOffsetGain() const;
+
+  /* センサー位置でのライン横ずれを取得 [m] (ラインの左が正、未同定なら0) */
+  float GetOffset() const;
+
   /* ラインがないか */
   bool IsNone() const;
 
-  /* 交差か */
+  /* 交差か (センサー位置) */
   bool IsCrossPassed() const;
 
+  /* 車軸が交差を通過したか */
+  bool IsCrossPassedAtAxle() const;
+
+  /* 健全性を取得 */
+  std::array<Health, kNum> GetHealth() const;
+
+  /* 健全性を表示 */
+  void PrintHealth() const;
+
  private:
   mutable Mutex mtx_;
 
   std::array<float, kNum> coeff_;
   std::array<uint16_t, kNum> min_;
   std::array<uint16_t, kNum> max_;
+  std::array<Envelope<float>, kNum> envelope_; /* 走行中に追従する下限・上限 */
+  float envelopeDistance_;                     /* 下限・上限を前回更新した距離 [m] */
+  float errorToOffset_{0.0f};                  /* エラーから横ずれへの換算 [m] */
+
+  /* センサーの健全性 (キャリブレーションするまで走行をまたいで保持) */
+  std::array<Health, kNum> health_;
+  std::array<uint16_t, kNum> windowMin_; /* 区間内の最小値 */
+  std::array<uint16_t, kNum> windowMax_; /* 区間内の最大値 */
+  std::array<uint16_t, kNum> lastRaw_;   /* 前回の生値 */
+  float healthDistance_;                 /* 区間の開始距離 [m] */
+
+  /* 健全性を更新 */
+  void UpdateHealth(const std::array<uint16_t, kNum> &raw, const std::array<float, kNum> &normalized, float distance);
+  /* 健全か */
+  bool IsHealthy(uint32_t order) const;
+  /* 異常なチャンネルの正規化値を並びの両隣から補間 */
+  void Interpolate(std::array<float, kNum> &normalized) const;
 
   State state_;                                           /* 前回の状態 */
   uint8_t detectNum_;                                     /* 反応センサーの個数 */
   float brownOutDistance_;                                /* ライン無反応開始距離 [m] */
   MovingAverage<float, float, kLineNumErrorMovingAverage> /* エラーの移動平均 */
       errorAverage_;
+
+  /* 車軸位置への遅延 */
+  DistanceDelay<float, kSensorDelayNumPoints> errorDelay_;     /* エラー */
+  DistanceDelay<bool, kSensorEventDelayNumPoints> crossDelay_; /* 交差 */
+  float errorAtAxle_;                                          /* 車軸位置でのエラー */
+  bool crossPassedAtAxle_;                                     /* 車軸が交差を通過したか */
 };
 }  // namespace LineSensing
 
@@ -74,45 +74,69 @@ bool LineSensing::LoadCalibrationData() {
 
 /* キャリブレーション */
 bool LineSensing::StoreCalibrationData(uint32_t sampleNum) {
-  std::array<uint16_t, LineImpl::kNum> lineMin;
-  std::array<uint16_t, LineImpl::kNum> lineMax;
-  std::array<float, LineImpl::kNum> lineCoeff;
-  std::array<uint16_t, MarkerImpl::kNum> markerMax;
-  auto &markerAdc = MarkerAdc::Instance();
-  auto &lineAdc = LineAdc::Instance();
-  bool failed = false;
-  lineMin.fill(UINT16_MAX);
-  lineMax.fill(0);
-  markerMax.fill(0);
+  ResetCalibrationSample();
   for (uint32_t n = 0; n < sampleNum; n++) {
     if (!Periodic::WaitPeriodicNotify()) {
       return false;
     }
-    if (!TurnOnIrLed() || !lineAdc.Fetch() || !markerAdc.Fetch()) {
-      failed = true;
-      break;
-    }
-    /* 最大値・最小値を取得 */
-    for (uint32_t num = 0; num < lineAdc.kNum; num++) {
-      uint16_t raw = lineAdc.GetRaw(num);
-      lineMax[num] = std::max(lineMax[num], raw);
-      lineMin[num] = std::min(lineMin[num], raw);
-    }
-    for (uint32_t num = 0; num < markerAdc.kNum; num++) {
-      uint16_t raw = markerAdc.GetRaw(num);
-      markerMax[num] = std::max(markerMax[num], raw);
+    if (!SampleCalibration()) {
+      return false;
     }
-    TurnOffIrLed();
   }
-  if (failed) {
+  return FinishCalibration();
+}
+
+/* キャリブレーションのサンプルを破棄 */
+void LineSensing::ResetCalibrationSample() {
+  for (auto &histogram : lineHistogram_) {
+    histogram.Reset();
+  }
+  for (auto &histogram : markerHistogram_) {
+    histogram.Reset();
+  }
+}
+
+/* キャリブレーションのサンプルを1回取得 */
+bool LineSensing::SampleCalibration() {
+  auto &markerAdc = MarkerAdc::Instance();
+  auto &lineAdc = LineAdc::Instance();
+  if (!TurnOnIrLed() || !lineAdc.Fetch() || !markerAdc.Fetch()) {
     TurnOffIrLed();
     return false;
   }
-  /* 係数を計算 */
   for (uint32_t num = 0; num < lineAdc.kNum; num++) {
-    lineCoeff[num] = 1 / static_cast<float>(lineMax[num] - lineMin[num]);
+    lineHistogram_[num].Add(lineAdc.GetRaw(num));
+  }
+  for (uint32_t num = 0; num < markerAdc.kNum; num++) {
+    markerHistogram_[num].Add(markerAdc.GetRaw(num));
   }
-  printf(" ----- LineSensing::StoreCalibrationData(%ld) ----- \r\n", sampleNum);
+  TurnOffIrLed();
+  return true;
+}
+
+/* サンプルの分位点からキャリブレーション値を求めて不揮発メモリに保存 */
+bool LineSensing::FinishCalibration() {
+  std::array<uint16_t, LineImpl::kNum> lineMin;
+  std::array<uint16_t, LineImpl::kNum> lineMax;
+  std::array<float, LineImpl::kNum> lineCoeff;
+  std::array<uint16_t, MarkerImpl::kNum> markerMax;
+  /* 一瞬の反射(最大値)や影(最小値)で決まらないよう、絶対的な最大・最小ではなく分位点を使う */
+  bool valid = true;
+  for (uint32_t num = 0; num < LineImpl::kNum; num++) {
+    lineMin[num] = static_cast<uint16_t>(lineHistogram_[num].GetPercentile(kLineCalibrationMinPercentile));
+    lineMax[num] = static_cast<uint16_t>(lineHistogram_[num].GetPercentile(kLineCalibrationMaxPercentile));
+    if (lineMax[num] < lineMin[num] + kLineCalibrationMinContrast) {
+      valid = false;
+    }
+    lineCoeff[num] = 1 / static_cast<float>(std::max(lineMax[num] - lineMin[num], 1));
+  }
+  for (uint32_t num = 0; num < MarkerImpl::kNum; num++) {
+    markerMax[num] = static_cast<uint16_t>(markerHistogram_[num].GetPercentile(kLineCalibrationMaxPercentile));
+    if (markerMax[num] < kLineCalibrationMinContrast) {
+      valid = false;
+    }
+  }
+  printf(" ----- LineSensing::FinishCalibration(%ld) ----- \r\n", lineHistogram_[0].GetCount());
   for (uint32_t ch = 0; ch < 8; ch++) {
     printf("Right%ld Min: %d, Max: %d, Coeff: %f\r\n", ch, lineMin[ch], lineMax[ch],
            static_cast<double>(lineCoeff[ch]));
@@ -121,6 +145,11 @@ bool LineSensing::StoreCalibrationData(uint32_t sampleNum) {
   }
   printf("Marker Right Max: %d\r\n", markerMax[0]);
   printf("Marker Left  Max: %d\r\n", markerMax[1]);
+  /* ラインを見ていないセンサーがあれば保存しない */
+  if (!valid) {
+    printf("Calibration failed: insufficient contrast\r\n");
+    return false;
+  }
   if (!NonVolatileData::WriteLineSensorCalibrationData(lineMin, lineMax, lineCoeff, markerMax)) {
     return false;
   }
@@ -129,6 +158,28 @@ bool LineSensing::StoreCalibrationData(uint32_t sampleNum) {
   return true;
 }
 
+/* 不揮発メモリからエラーから横ずれへの換算を復元 */
+bool LineSensing::LoadOffsetGain() {
+  float errorToOffset = 0.0f;
+  if (!NonVolatileData::ReadLineOffsetData(errorToOffset)) {
+    return false;
+  }
+  /* 未書き込み・異常な値は使わない */
+  if (!std::isfinite(errorToOffset) || errorToOffset <= 0.0f || errorToOffset > kLineOffsetIdentMaxGain) {
+    return false;
+  }
+  printf(" ----- NonVolatileData::ReadLineOffsetData ----- \r\n");
+  printf("ErrorToOffset: %f [m]\r\n", static_cast<double>(errorToOffset));
+  line_.SetOffsetGain(errorToOffset);
+  return true;
+}
+
+/* エラーから横ずれへの換算を設定して不揮発メモリに保存 */
+bool LineSensing::StoreOffsetGain(float errorToOffset) {
+  line_.SetOffsetGain(errorToOffset);
+  return NonVolatileData::WriteLineOffsetData(errorToOffset);
+}
+
 /* タスク */
 void LineSensing::TaskEntry() {
   uint32_t notify = 0;
@@ -145,6 +196,7 @@ void LineSensing::TaskEntry() {
         /* TODO: エラーハンドリング */
       }
       if (notify & kTaskNotifyBitStop) {
+        line_.PrintHealth();
         break;
       }
       if (notify & kTaskNotifyBitPeriodic) {
@@ -5,6 +5,7 @@
 #include <main.h>
 
 /* Projects */
+#include "Data/Histogram.h"
 #include "Line.h"
 #include "Marker.h"
 #include "Wrapper/Task.h"
@@ -21,15 +22,30 @@ class LineSensing final : public Task<LineSensing> {
   /* 不揮発メモリからキャリブレーション情報を復元 */
   bool LoadCalibrationData();
 
-  /* キャリブレーション */
+  /* キャリブレーション (手で動かす間に周期ごとにサンプリング) */
   bool StoreCalibrationData(uint32_t sampleNum);
 
+  /* キャリブレーションのサンプルを破棄 (タスクの停止中に使う) */
+  void ResetCalibrationSample();
+  /* キャリブレーションのサンプルを1回取得 */
+  bool SampleCalibration();
+  /* サンプルの分位点からキャリブレーション値を求めて不揮発メモリに保存 */
+  bool FinishCalibration();
+
+  /* 不揮発メモリからエラーから横ずれへの換算を復元 */
+  bool LoadOffsetGain();
+  /* エラーから横ずれへの換算を設定して不揮発メモリに保存 */
+  bool StoreOffsetGain(float errorToOffset);
+
   /* ラインを取得 */
   const LineImpl &Line() { return line_; }
 
   /* マーカーを取得 */
   const MarkerImpl &Marker() { return marker_; }
 
+  /* マーカーを受け付けるかを設定 (右: スタート・ゴール, 左: 曲率) */
+  void SetMarkerGate(const std::array<bool, MarkerImpl::kNum> &open) { marker_.SetGate(open); }
+
  protected:
   /* タスク */
   void TaskEntry() final;
@@ -38,6 +54,10 @@ class LineSensing final : public Task<LineSensing> {
   MarkerImpl marker_;
   LineImpl line_;
 
+  /* キャリブレーションのサンプル */
+  std::array<Histogram<kLineCalibrationNumBins, LineAdc::kAdcMaxValue>, LineImpl::kNum> lineHistogram_;
+  std::array<Histogram<kLineCalibrationNumBins, MarkerAdc::kAdcMaxValue>, MarkerImpl::kNum> markerHistogram_;
+
   /* IR LED点灯待ち */
   static void PeriodElapsedCallback(TIM_HandleTypeDef *);
   StaticSemaphore_t periodElapsedSemphrBuffer_;
@@ -1,6 +1,8 @@
 #include "LineSensing/Marker.h"
 
 /* C++ */
+#include <algorithm>
+#include <cmath>
 #include <mutex>
 
 /* グローバル変数定義 */
@@ -45,12 +47,20 @@ uint16_t MarkerAdc::GetRaw(uint32_t order) { return adc1Buffer_[order] & 0x0fff;
 void MarkerImpl::Reset() {
   std::scoped_lock<Mutex> lock(mtx_);
   ignoreDistance_ = 0.0f;
+  envelopeDistance_ = 0.0f;
   for (uint32_t order = 0; order < MarkerAdc::kNum; order++) {
+    /* 走行ごとにキャリブレーション値から追従し直す */
+    envelope_[order].Reset(0.0f, max_[order], MarkerAdc::kAdcMaxValue);
+    peak_[order] = 0.0f;
     state_[order] = State::kWaiting;
     count_[order] = 0;
+    gate_[order] = true;
+    rejectedCount_[order] = 0;
     detectDistance_[order] = 0.0f;
     average_[order].Reset();
   }
+  curvatureDelay_.Reset();
+  curvatureAtAxle_ = false;
 }
 
 /* 更新 */
@@ -61,11 +71,14 @@ bool MarkerImpl::Update(float distance) {
   }
   {
     std::scoped_lock<Mutex> lock(mtx_);
+    float ratio = std::abs(distance - envelopeDistance_) / kSensorEnvelopeDistance;
+    envelopeDistance_ = distance;
     for (uint32_t order = 0; order < MarkerAdc::kNum; order++) {
       uint16_t raw = adc.GetRaw(order);
 
       average_[order].Update(raw);
-      bool isDetect = average_[order].Get() > threshold_[order];
+      float value = average_[order].Get();
+      bool isDetect = value > envelope_[order].GetThreshold(kMarkerDetectThreshold);
       switch (state_[order]) {
         case State::kIgnoring:
           /* 交差を検出した場合はセンサー間の距離だけ無視する */
@@ -77,17 +90,29 @@ bool MarkerImpl::Update(float distance) {
           /* 検出されたら位置を記録 */
           if (isDetect) {
             detectDistance_[order] = distance;
+            peak_[order] = value;
             state_[order] = State::kPassing;
+          } else {
+            /* マーカー間は背景なので下限を追従 */
+            envelope_[order].UpdateFloor(value, ratio);
           }
           break;
         case State::kPassing:
           /* マーカーの幅がしきい値より小さい場合は無視 */
+          peak_[order] = std::max(peak_[order], value);
           if (!isDetect) {
             if (std::abs(distance - detectDistance_[order]) < kMarkerDetectDistance) {
               state_[order] = State::kWaiting;
+            } else if (!gate_[order]) {
+              /* 予想される範囲の外なので誤検出として捨てる */
+              state_[order] = State::kWaiting;
+              rejectedCount_[order]++;
             } else {
               state_[order] = State::kPassed;
               count_[order]++;
+              /* 受け付けたマーカーの最大値で上限を追従 (マーカーの長さ分だけ進める) */
+              float length = std::abs(distance - detectDistance_[order]);
+              envelope_[order].UpdateCeiling(peak_[order], length / kSensorEnvelopeDistance);
             }
           }
           break;
@@ -97,6 +122,12 @@ bool MarkerImpl::Update(float distance) {
           break;
       }
     }
+    /* 曲率マーカーを車軸位置へ遅延 */
+    if (state_[1] == State::kPassed) {
+      curvatureDelay_.Push(distance + kMarkerDistanceFromCenter, true);
+    }
+    bool passed = false;
+    curvatureAtAxle_ = curvatureDelay_.Pop(distance, passed);
   }
   return true;
 }
@@ -104,8 +135,9 @@ bool MarkerImpl::Update(float distance) {
 /* 閾値を設定 */
 void MarkerImpl::SetCalibration(const std::array<uint16_t, kNum> &max) {
   std::scoped_lock<Mutex> lock(mtx_);
+  max_ = max;
   for (uint32_t order = 0; order < MarkerAdc::kNum; order++) {
-    threshold_[order] = max[order] * kMarkerDetectThreshold;
+    envelope_[order].Reset(0.0f, max_[order], MarkerAdc::kAdcMaxValue);
   }
 }
 
@@ -118,6 +150,12 @@ void MarkerImpl::SetIgnore(float distance) {
   }
 }
 
+/* マーカーを受け付けるかを設定 */
+void MarkerImpl::SetGate(const std::array<bool, kNum> &open) {
+  std::scoped_lock<Mutex> lock(mtx_);
+  gate_ = open;
+}
+
 /* 状態を取得 */
 std::array<MarkerImpl::State, MarkerImpl::kNum> MarkerImpl::GetState() const {
   std::scoped_lock<Mutex> lock(mtx_);
@@ -130,6 +168,12 @@ std::array<uint32_t, MarkerImpl::kNum> MarkerImpl::GetCount() const {
   return count_;
 }
 
+/* 誤検出として捨てた回数を取得 */
+std::array<uint32_t, MarkerImpl::kNum> MarkerImpl::GetRejectedCount() const {
+  std::scoped_lock<Mutex> lock(mtx_);
+  return rejectedCount_;
+}
+
 /* スタートしたか */
 bool MarkerImpl::IsStarted() const { return count_[0] > 0; }
 
@@ -138,4 +182,7 @@ bool MarkerImpl::IsGoaled() const { return count_[0] > 1; }
 
 /* 曲率マーカーがあったか */
 bool MarkerImpl::IsCurvature() const { return state_[1] == State::kPassed; };
+
+/* 車軸が曲率マーカーを通過したか */
+bool MarkerImpl::IsCurvatureAtAxle() const { return curvatureAtAxle_; }
 }  // namespace LineSensing
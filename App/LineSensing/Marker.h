@@ -13,6 +13,8 @@
 
 /* Project */
 #include "Config.h"
+#include "Data/DistanceDelay.h"
+#include "Data/Envelope.h"
 #include "Data/MovingAverage.h"
 #include "Data/Singleton.h"
 #include "Wrapper/Mutex.h"
@@ -69,21 +71,30 @@ class MarkerImpl {
   /* 無視開始距離を設定 */
   void SetIgnore(float distance);
 
+  /* マーカーを受け付けるかを設定 (閉じている間に通過したマーカーは誤検出として数えない) */
+  void SetGate(const std::array<bool, kNum> &open);
+
   /* 状態を取得 */
   std::array<State, kNum> GetState() const;
 
   /* 検知回数を取得 */
   std::array<uint32_t, kNum> GetCount() const;
 
+  /* 誤検出として捨てた回数を取得 */
+  std::array<uint32_t, kNum> GetRejectedCount() const;
+
   /* スタートしたか */
   bool IsStarted() const;
 
   /* ゴールしたか */
   bool IsGoaled() const;
 
-  /* 曲率マーカーがあったか */
+  /* 曲率マーカーがあったか (センサー位置) */
   bool IsCurvature() const;
 
+  /* 車軸が曲率マーカーを通過したか */
+  bool IsCurvatureAtAxle() const;
+
  private:
   using Average = MovingAverage<uint16_t, uint16_t, kMarkerNumMovingAverage>;
 
@@ -91,10 +102,19 @@ class MarkerImpl {
 
   std::array<Average, kNum> average_;              /* ADC移動平均 */
   std::array<State, kNum> state_{State::kWaiting}; /* 前回の状態 */
-  std::array<float, kNum> threshold_;              /* 検出閾値 */
+  std::array<uint16_t, kNum> max_;                 /* キャリブレーションの最大値 */
+  std::array<Envelope<float>, kNum> envelope_;     /* 走行中に追従する下限・上限 */
+  std::array<float, kNum> peak_;                   /* 通過中の最大値 */
+  float envelopeDistance_;                         /* 下限を前回更新した距離 [m] */
   std::array<uint32_t, kNum> count_;               /* 検知回数 */
+  std::array<bool, kNum> gate_;                    /* マーカーを受け付けるか */
+  std::array<uint32_t, kNum> rejectedCount_;       /* 誤検出として捨てた回数 */
   std::array<float, kNum> detectDistance_;         /* 検出開始距離 [m] */
   float ignoreDistance_;                           /* 無視開始距離 [m] */
+
+  /* 車軸位置への遅延 */
+  DistanceDelay<bool, kSensorEventDelayNumPoints> curvatureDelay_; /* 曲率マーカー */
+  bool curvatureAtAxle_;                                           /* 車軸が曲率マーカーを通過したか */
 };
 }  // namespace LineSensing
 #endif  // LINESENSING_MARKER_H_
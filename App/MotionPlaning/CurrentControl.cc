@@ -0,0 +1,176 @@
+#include "MotionPlaning/CurrentControl.h"
+
+/* FreeRTOS */
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* C++ */
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+/* Project */
+#include "MotionPlaning/Motor.h"
+#include "PowerMonitoring/PowerAdc.h"
+
+/* グローバル変数定義 */
+extern TIM_HandleTypeDef htim1;
+extern ADC_HandleTypeDef hadc2;
+
+namespace MotionPlaning {
+/* 初期化 */
+bool CurrentControl::Initialize() {
+  /* TIM1 は中央揃えPWMで、カウンタ0(ONパルスの中央)の更新イベントをTRGOに出す (rt-linelight_v2.ioc で設定) */
+  /* 中央揃えでは山と谷で繰り返しカウンタが減るので、(RCR+1)を偶数にすると常に谷で更新される */
+  static_assert((2 * kMotorPwmFrequency / kCurrentControlFrequency) % 2 == 0, "RCR + 1 must be even");
+  if (htim1.Init.CounterMode != TIM_COUNTERMODE_CENTERALIGNED1 ||
+      htim1.Init.Period != 200000000 / (2 * kMotorPwmFrequency) - 1 ||
+      htim1.Init.RepetitionCounter != 2 * kMotorPwmFrequency / kCurrentControlFrequency - 1) {
+    return false;
+  }
+
+  /* ADC2 インジェクテッドグループで左右の電流をTIM1 TRGOに同期して変換 */
+  static constexpr uint32_t channels[] = {ADC_CHANNEL_3, ADC_CHANNEL_5}; /* 右, 左 */
+  static constexpr uint32_t ranks[] = {ADC_INJECTED_RANK_1, ADC_INJECTED_RANK_2};
+  /* レギュラー変換(PowerAdc)中はサンプリング時間などが反映されないので、変換を止めてから設定する */
+  /* 止まるのは臨界区間の外で時間制限付きで待つ (止めた回の PowerAdc::Fetch はタイムアウトする) */
+  uint32_t start = HAL_GetTick();
+  while (true) {
+    if (LL_ADC_REG_IsConversionOngoing(hadc2.Instance)) {
+      if (HAL_GetTick() - start > kAdcStopTimeout) {
+        return false;
+      }
+      if (!LL_ADC_REG_IsStopConversionOngoing(hadc2.Instance)) {
+        LL_ADC_REG_StopConversion(hadc2.Instance);
+      }
+      continue;
+    }
+    taskENTER_CRITICAL();
+    /* 待っている間に PowerAdc::Fetch が次の変換を始めていたらやり直す */
+    bool idle = !LL_ADC_REG_IsConversionOngoing(hadc2.Instance);
+    bool configured = idle;
+    for (int i = 0; configured && i < 2; i++) {
+      ADC_InjectionConfTypeDef config = {};
+      config.InjectedChannel = channels[i];
+      config.InjectedRank = ranks[i];
+      config.InjectedSamplingTime = ADC_SAMPLETIME_16CYCLES_5;
+      config.InjectedSingleDiff = ADC_SINGLE_ENDED;
+      config.InjectedOffsetNumber = ADC_OFFSET_NONE;
+      config.InjectedOffset = 0;
+      config.InjectedNbrOfConversion = 2;
+      config.InjectedDiscontinuousConvMode = DISABLE;
+      config.AutoInjectedConv = DISABLE;
+      config.QueueInjectedContext = DISABLE;
+      config.ExternalTrigInjecConv = ADC_EXTERNALTRIGINJEC_T1_TRGO;
+      config.ExternalTrigInjecConvEdge = ADC_EXTERNALTRIGINJECCONV_EDGE_RISING;
+      config.InjecOversamplingMode = DISABLE;
+      configured = HAL_ADCEx_InjectedConfigChannel(&hadc2, &config) == HAL_OK;
+    }
+    taskEXIT_CRITICAL();
+    if (idle) {
+      if (!configured) {
+        return false;
+      }
+      break;
+    }
+  }
+  if (HAL_ADC_RegisterCallback(&hadc2, HAL_ADC_INJ_CONVERSION_COMPLETE_CB_ID, InjectedConvCpltCallback) != HAL_OK) {
+    return false;
+  }
+  HAL_NVIC_SetPriority(ADC_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(ADC_IRQn);
+  return HAL_ADCEx_InjectedStart_IT(&hadc2) == HAL_OK;
+}
+
+/* 有効化 */
+void CurrentControl::Enable() {
+  taskENTER_CRITICAL();
+  reference_ = {};
+  backEmf_ = {};
+  integral_ = {};
+  enabled_ = true;
+  taskEXIT_CRITICAL();
+}
+
+/* 無効化 */
+void CurrentControl::Disable() {
+  taskENTER_CRITICAL();
+  enabled_ = false;
+  taskEXIT_CRITICAL();
+}
+
+/* 外側ループの電圧指令から電流指令を設定 */
+void CurrentControl::SetVoltageReference(const Amount &voltage, const Amount &wheelOmega, float batteryVoltage) {
+  static constexpr float kRadPerSecToRpm = (60.0f * kGearRatio) / (2.0f * std::numbers::pi_v<float>);
+  Amount backEmf{}, reference{};
+  for (int i = 0; i < 2; i++) {
+    /* 定常で同じ電圧になる電流を指令とし、上限で制限する */
+    backEmf[i] = kMotorBackEmf * kRadPerSecToRpm * wheelOmega[i];
+    reference[i] = std::clamp((voltage[i] - backEmf[i]) / resistance_[i], -currentLimit_[i], currentLimit_[i]);
+  }
+  taskENTER_CRITICAL();
+  reference_ = reference;
+  backEmf_ = backEmf;
+  batteryVoltage_ = batteryVoltage;
+  taskEXIT_CRITICAL();
+}
+
+/* 温度で変わるモーター抵抗と許容電流を設定 */
+void CurrentControl::SetMotorModel(const Amount &resistance, const Amount &currentLimit) {
+  taskENTER_CRITICAL();
+  resistance_ = resistance;
+  currentLimit_ = currentLimit;
+  taskEXIT_CRITICAL();
+}
+
+/* 電流指令を取得 [A] */
+CurrentControl::Amount CurrentControl::GetReference() const {
+  taskENTER_CRITICAL();
+  Amount reference = reference_;
+  taskEXIT_CRITICAL();
+  return reference;
+}
+
+/* 計測電流を取得 [A] */
+CurrentControl::Amount CurrentControl::GetCurrent() const {
+  taskENTER_CRITICAL();
+  Amount current = current_;
+  taskEXIT_CRITICAL();
+  return current;
+}
+
+/* インジェクテッド変換完了コールバック */
+void CurrentControl::InjectedConvCpltCallback(ADC_HandleTypeDef *hadc) {
+  CurrentControl::Instance().Update({
+      HAL_ADCEx_InjectedGetValue(hadc, ADC_INJECTED_RANK_1),
+      HAL_ADCEx_InjectedGetValue(hadc, ADC_INJECTED_RANK_2),
+  });
+}
+
+/* 電流制御を更新 (割り込みから呼び出し) */
+void CurrentControl::Update(const std::array<uint32_t, 2> &raw) {
+  updateCount_ = updateCount_ + 1;
+  for (int i = 0; i < 2; i++) {
+    current_[i] = PowerMonitoring::PowerAdc::ConvertMotorCurrent(raw[i]);
+  }
+  if (!enabled_ || batteryVoltage_ <= 0.0f) {
+    return;
+  }
+  float limit = std::min(kMotorLimitVoltage, batteryVoltage_);
+  Motor::Duty duty{};
+  for (int i = 0; i < 2; i++) {
+    /* 抵抗分と逆起電力をFFとし、誤差をPIで補償 */
+    float error = reference_[i] - current_[i];
+    float feedforward = resistance_[i] * reference_[i] + backEmf_[i];
+    float integral = integral_[i] + kCurrentControlKi * error * kDt;
+    float voltage = feedforward + kCurrentControlKp * error + integral;
+    /* 飽和中は積分を止める */
+    if (std::abs(voltage) < limit) {
+      integral_[i] = integral;
+    }
+    voltage = std::clamp(voltage, -limit, limit);
+    duty[i] = voltage / batteryVoltage_;
+  }
+  Motor::Instance().SetDuty(duty);
+}
+}  // namespace MotionPlaning
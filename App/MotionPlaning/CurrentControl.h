@@ -0,0 +1,71 @@
+#ifndef MOTIONPLANING_CURRENTCONTROL_H_
+#define MOTIONPLANING_CURRENTCONTROL_H_
+
+/* STM32CubeMX */
+#include <main.h>
+
+/* Project */
+#include "Config.h"
+#include "Data/Singleton.h"
+
+/* C++ */
+#include <array>
+
+namespace MotionPlaning {
+/* 電流制御 (PWM中央で同期サンプリングした電流でモーター電圧を決定する内側ループ) */
+class CurrentControl final : public Singleton<CurrentControl> {
+ public:
+  using Amount = std::array<float, 2>;
+
+  /* 初期化 (Motor::Initialize でPWMを開始する前に呼び出すこと) */
+  bool Initialize();
+
+  /* 有効化 */
+  void Enable();
+  /* 無効化 (以降デューティを書き換えない) */
+  void Disable();
+
+  /* 外側ループの電圧指令から電流指令を設定 */
+  void SetVoltageReference(const Amount &voltage,    /* 速度サーボの出力電圧 [V] */
+                           const Amount &wheelOmega, /* 車輪角速度 [rad/s] */
+                           float batteryVoltage      /* バッテリー電圧 [V] */
+  );
+
+  /* 温度で変わるモーター抵抗と許容電流を設定 */
+  void SetMotorModel(const Amount &resistance,  /* モーター抵抗 [Ω] */
+                     const Amount &currentLimit /* 許容電流 [A] */
+  );
+
+  /* 電流指令を取得 [A] */
+  Amount GetReference() const;
+  /* 計測電流を取得 [A] */
+  Amount GetCurrent() const;
+
+  /* 内側ループの更新回数を取得 (割り込みが届き続けているかの確認用) */
+  uint32_t GetUpdateCount() const { return updateCount_; }
+
+ private:
+  static constexpr float kDt = 1.0f / static_cast<float>(kCurrentControlFrequency); /* 制御周期 [s] */
+
+  /* 割り込みと共有する値 */
+  volatile bool enabled_{false};
+  volatile uint32_t updateCount_{0}; /* 更新回数 */
+  Amount reference_{};      /* 電流指令 [A] */
+  Amount backEmf_{};        /* 逆起電力 [V] */
+  float batteryVoltage_{0}; /* バッテリー電圧 [V] */
+  Amount current_{};        /* 計測電流 [A] */
+  Amount integral_{};       /* 積分項 [V] */
+
+  /* 温度で変わるモーターの値 */
+  Amount resistance_{kMotorResistance, kMotorResistance};       /* モーター抵抗 [Ω] */
+  Amount currentLimit_{kMotorCurrentLimit, kMotorCurrentLimit}; /* 許容電流 [A] */
+
+  /* インジェクテッド変換完了コールバック */
+  static void InjectedConvCpltCallback(ADC_HandleTypeDef *hadc);
+
+  /* 電流制御を更新 (割り込みから呼び出し) */
+  void Update(const std::array<uint32_t, 2> &raw);
+};
+}  // namespace MotionPlaning
+
+#endif  // MOTIONPLANING_CURRENTCONTROL_H_
@@ -0,0 +1,48 @@
+#include "MotionPlaning/LateralControl.h"
+
+/* C++ */
+#include <algorithm>
+
+namespace MotionPlaning {
+/* リセット */
+void LateralControl::Reset() {
+  filter_.Reset({0.0f, 0.0f}, {{
+                                  {kLateralSensorNoise * kLateralSensorNoise, 0.0f},
+                                  {0.0f, 0.1f * 0.1f},
+                              }});
+}
+
+/* 推定だけ更新 */
+void LateralControl::Estimate(float sensorOffset, bool valid, float velocity, float yawRate, float curvature) {
+  static constexpr float dt = kPeriodicNotifyInterval;
+  static constexpr float kQ00 = (kLateralSlipNoise * dt) * (kLateralSlipNoise * dt);
+  static constexpr float kQ11 = (kLateralYawRateNoise * dt) * (kLateralYawRateNoise * dt);
+  static constexpr float kR = kLateralSensorNoise * kLateralSensorNoise;
+
+  /* 予測 (dy = v ψ, dψ = ω - v κ) */
+  filter_.Predict({{{1.0f, velocity * dt}, {0.0f, 1.0f}}}, {0.0f, (yawRate - velocity * curvature) * dt},
+                  {{{kQ00, 0.0f}, {0.0f, kQ11}}});
+  /* センサー位置の横ずれで補正 */
+  if (valid) {
+    filter_.Correct({1.0f, kLineDistanceFromCenter}, sensorOffset, kR);
+  }
+}
+
+/* 推定を更新して角速度指令を返す */
+float LateralControl::Update(float sensorOffset, bool valid, float velocity, float yawRate, float curvature) {
+  /* 距離領域で固有角周波数 ωn, 減衰比 ζ となる極配置 (速度が変わっても同じ距離で収束する) */
+  static constexpr float kGainOffset = kLateralNaturalFrequency * kLateralNaturalFrequency;
+  static constexpr float kGainHeading = 2.0f * kLateralDampingRatio * kLateralNaturalFrequency;
+
+  Estimate(sensorOffset, valid, velocity, yawRate, curvature);
+  const auto &x = filter_.Get();
+  float angularVelocity = velocity * (curvature - kGainOffset * x[0] - kGainHeading * x[1]);
+  return std::clamp(angularVelocity, -kLineErrorMaxAngularVelocity, kLineErrorMaxAngularVelocity);
+}
+
+/* 推定した車軸の横ずれを取得 */
+float LateralControl::GetOffset() const { return filter_.Get()[0]; }
+
+/* 推定したラインに対する向きを取得 */
+float LateralControl::GetHeading() const { return filter_.Get()[1]; }
+}  // namespace MotionPlaning
@@ -0,0 +1,38 @@
+#ifndef MOTIONPLANING_LATERALCONTROL_H_
+#define MOTIONPLANING_LATERALCONTROL_H_
+
+/* Project */
+#include "Config.h"
+#include "Data/KalmanFilter.h"
+
+namespace MotionPlaning {
+/* ラインに対する横ずれと向きを推定して角速度を決める状態フィードバック制御 */
+/* 状態は車軸の横ずれ y [m] (ラインの左が正) と向き ψ [rad] (反時計回りが正) */
+/* センサーは車軸の kLineDistanceFromCenter 前方にあるので観測は y + L ψ */
+class LateralControl {
+ public:
+  /* リセット */
+  void Reset();
+
+  /* 推定だけ更新 (PIDで追従中もコースアウト復帰のために横ずれと向きを推定する) */
+  void Estimate(float sensorOffset, /* センサー位置でのライン横ずれ [m] */
+                bool valid,         /* 横ずれが有効か (交差・コースアウト中は無効) */
+                float velocity,     /* 速度 [m/s] */
+                float yawRate,      /* 角速度 [rad/s] */
+                float curvature     /* ラインの曲率 [1/m] */
+  );
+
+  /* 推定を更新して角速度指令を返す [rad/s] */
+  float Update(float sensorOffset, bool valid, float velocity, float yawRate, float curvature);
+
+  /* 推定した車軸の横ずれを取得 [m] */
+  float GetOffset() const;
+  /* 推定したラインに対する向きを取得 [rad] */
+  float GetHeading() const;
+
+ private:
+  KalmanFilter2<float> filter_;
+};
+}  // namespace MotionPlaning
+
+#endif  // MOTIONPLANING_LATERALCONTROL_H_
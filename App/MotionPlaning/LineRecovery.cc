@@ -0,0 +1,60 @@
+#include "MotionPlaning/LineRecovery.h"
+
+/* C++ */
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace MotionPlaning {
+/* ラインを見ている間の状態を記録 */
+void LineRecovery::Record(const MotionSensing::Pose &pose, float sensorOffset, float heading, float curvature,
+                          float distance) {
+  /* センサー位置から横ずれの分だけ右(ラインの左が正なので逆向き)にずらした点がライン上 */
+  float sensorX = pose.x + kLineDistanceFromCenter * std::cos(pose.theta);
+  float sensorY = pose.y + kLineDistanceFromCenter * std::sin(pose.theta);
+  lineX_ = sensorX + sensorOffset * std::sin(pose.theta);
+  lineY_ = sensorY - sensorOffset * std::cos(pose.theta);
+  lineDirection_ = pose.theta - heading;
+  curvature_ = std::clamp(curvature, -kCourseOutRecoveryMaxCurvature, kCourseOutRecoveryMaxCurvature);
+  distance_ = distance;
+}
+
+/* 復帰を開始 */
+void LineRecovery::Start() { active_ = true; }
+/* 復帰を終了 */
+void LineRecovery::Stop() { active_ = false; }
+/* 復帰中か */
+bool LineRecovery::IsActive() const { return active_; }
+
+/* ラインを最後に見た位置から進んだ距離を取得 */
+float LineRecovery::GetLostDistance(float distance) const { return distance - distance_; }
+
+/* 更新して角速度指令を返す */
+float LineRecovery::Update(const MotionSensing::Pose &pose, float velocity) {
+  static constexpr float kGainOffset = kLateralNaturalFrequency * kLateralNaturalFrequency;
+  static constexpr float kGainHeading = 2.0f * kLateralDampingRatio * kLateralNaturalFrequency;
+  static constexpr float kMinCurvature = 1.0e-3f; /* これ未満は直線として扱う [1/m] */
+
+  /* 延長した経路に対する車軸の横ずれ y (経路の左が正) と経路の接線方向 */
+  float dx = pose.x - lineX_;
+  float dy = pose.y - lineY_;
+  float offset = 0.0f, tangent = 0.0f;
+  if (std::abs(curvature_) < kMinCurvature) {
+    offset = -dx * std::sin(lineDirection_) + dy * std::cos(lineDirection_);
+    tangent = lineDirection_;
+  } else {
+    /* 円弧の中心は経路の左(曲率が負なら右)に半径の距離 */
+    float radius = 1.0f / curvature_;
+    float cx = -radius * std::sin(lineDirection_) - dx;
+    float cy = radius * std::cos(lineDirection_) - dy;
+    float distance = std::hypot(cx, cy);
+    offset = radius - std::copysign(distance, radius);
+    /* 中心から車軸への向きを進行方向へ90度回すと接線 */
+    float direction = std::atan2(-cy, -cx);
+    tangent = direction + std::copysign(std::numbers::pi_v<float> / 2.0f, radius);
+  }
+  float heading = std::remainder(pose.theta - tangent, 2.0f * std::numbers::pi_v<float>);
+  float angularVelocity = velocity * (curvature_ - kGainOffset * offset - kGainHeading * heading);
+  return std::clamp(angularVelocity, -kLineErrorMaxAngularVelocity, kLineErrorMaxAngularVelocity);
+}
+}  // namespace MotionPlaning
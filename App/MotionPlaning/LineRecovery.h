@@ -0,0 +1,47 @@
+#ifndef MOTIONPLANING_LINERECOVERY_H_
+#define MOTIONPLANING_LINERECOVERY_H_
+
+/* Project */
+#include "Config.h"
+#include "MotionSensing/Odometry.h"
+
+namespace MotionPlaning {
+/* コースアウトからの復帰 */
+/* ラインを最後に見た位置・向き・曲率からラインを円弧(直線)で延長し、オドメトリの姿勢でその経路へ戻す */
+/* 制御則は LateralControl と同じ距離領域の極配置で、状態は延長した経路に対する車軸の横ずれと向き */
+class LineRecovery {
+ public:
+  /* ラインを見ている間の状態を記録 */
+  void Record(const MotionSensing::Pose &pose, /* 姿勢 */
+              float sensorOffset,              /* センサー位置でのライン横ずれ [m] (ラインの左が正) */
+              float heading,                   /* ラインに対する向き [rad] (不明なら0) */
+              float curvature,                 /* ラインの曲率 [1/m] */
+              float distance                   /* 走行距離 [m] */
+  );
+
+  /* 復帰を開始 (最後に記録した状態から経路を作る) */
+  void Start();
+  /* 復帰を終了 */
+  void Stop();
+  /* 復帰中か */
+  bool IsActive() const;
+
+  /* ラインを最後に見た位置から進んだ距離を取得 [m] */
+  float GetLostDistance(float distance) const;
+
+  /* 更新して角速度指令を返す [rad/s] */
+  float Update(const MotionSensing::Pose &pose, float velocity);
+
+ private:
+  /* ラインを最後に見たときの状態 */
+  float lineX_{0.0f};         /* ライン上の点 [m] */
+  float lineY_{0.0f};         /* ライン上の点 [m] */
+  float lineDirection_{0.0f}; /* ラインの向き [rad] */
+  float curvature_{0.0f};     /* ラインの曲率 [1/m] */
+  float distance_{0.0f};      /* 走行距離 [m] */
+
+  bool active_{false};
+};
+}  // namespace MotionPlaning
+
+#endif  // MOTIONPLANING_LINERECOVERY_H_
@@ -1,18 +1,31 @@
 #include "MotionPlaning/MotionPlaning.h"
 
 /* Projects */
+#include "FaultManager.h"
+#include "MotionPlaning/CurrentControl.h"
 #include "MotionPlaning/Motor.h"
 #include "MotionPlaning/Servo.h"
+#include "MotionSensing/Encoder.h"
 #include "MotionSensing/MotionSensing.h"
+#include "NonVolatileData.h"
 #include "Periodic.h"
 #include "PowerMonitoring/PowerMonitoring.h"
 
+/* C++ */
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
 namespace MotionPlaning {
 /* コンストラクタ */
 MotionPlaning::MotionPlaning() : servo_() {}
 
 /* 初期化 */
 bool MotionPlaning::Initialize() {
+  /* 電流制御初期化 (PWM開始前にタイマーを再設定する) */
+  if (!CurrentControl::Instance().Initialize()) {
+    return false;
+  }
   /* モーター初期化 */
   if (!Motor::Instance().Initialize()) {
     return false;
@@ -20,23 +33,62 @@ bool MotionPlaning::Initialize() {
   return TaskCreate("MotionPlaning", configMINIMAL_STACK_SIZE, kPriorityMotionPlaning);
 }
 
+/* 不揮発メモリから摩擦補償を読み込み */
+bool MotionPlaning::LoadFriction() {
+  ServoImpl::ControlAmount breakaway{}, coulomb{}, viscous{};
+  if (!NonVolatileData::ReadFrictionData(breakaway, coulomb, viscous)) {
+    return false;
+  }
+  /* 未書き込み・異常な値は使わない */
+  for (int i = 0; i < 2; i++) {
+    for (float v : {breakaway[i], coulomb[i], viscous[i]}) {
+      if (!std::isfinite(v) || v < 0.0f || v > kFrictionIdentMaxVoltage) {
+        return false;
+      }
+    }
+  }
+  printf(" ----- NonVolatileData::ReadFrictionData ----- \r\n");
+  printf("breakaway: %f, %f [V]\r\n", static_cast<double>(breakaway[0]), static_cast<double>(breakaway[1]));
+  printf("coulomb: %f, %f [V]\r\n", static_cast<double>(coulomb[0]), static_cast<double>(coulomb[1]));
+  printf("viscous: %f, %f [V/(m/s)]\r\n", static_cast<double>(viscous[0]), static_cast<double>(viscous[1]));
+  servo_.SetFriction(breakaway, coulomb, viscous);
+  return true;
+}
+
+/* 摩擦補償を設定して不揮発メモリに保存 */
+bool MotionPlaning::StoreFriction(const ServoImpl::ControlAmount &breakaway, const ServoImpl::ControlAmount &coulomb,
+                                  const ServoImpl::ControlAmount &viscous) {
+  servo_.SetFriction(breakaway, coulomb, viscous);
+  return NonVolatileData::WriteFrictionData(breakaway, coulomb, viscous);
+}
+
 /* タスク */
 void MotionPlaning::TaskEntry() {
   uint32_t notify = 0;
   auto &motor = Motor::Instance();
-  auto &power = PowerMonitoring::PowerMonitoring::Instance().Power();
+  auto &current = CurrentControl::Instance();
+  auto &encoder = MotionSensing::Encoder::Instance();
+  auto &powerMonitoring = PowerMonitoring::PowerMonitoring::Instance();
+  auto &power = powerMonitoring.Power();
   auto &odometry = MotionSensing::MotionSensing::Instance().Odometry();
+  auto &fault = FaultManager::Instance();
   Periodic::Instance().Add(TaskHandle());
   while (true) {
     TaskNotifyWaitStart();
+    /* モーターを再び有効にするので前回のフォールトのラッチを解除 (履歴は残る) */
+    fault.Clear();
     servo_.Reset();
     motor.Enable();
+    current.Enable();
+    bool braking = false;
+    uint32_t currentUpdateCount = current.GetUpdateCount();
     while (true) {
       /* TODO: タイムアウト */
       if (!TaskNotifyWait(notify)) {
         /* TODO: エラーハンドリング */
       }
       if (notify & kTaskNotifyBitStop) {
+        current.Disable();
         motor.Brake();
         motor.Disable();
         break;
@@ -44,12 +96,46 @@ void MotionPlaning::TaskEntry() {
       if (notify & kTaskNotifyBitPeriodic) {
         float batteryVoltage = power.GetBatteryVoltage();
         auto velo = odometry.GetVelocity();
+        /* モーター温度による抵抗の変化と電流の低減を反映 */
+        auto resistance = power.GetMotorResistance();
+        auto currentLimit = power.GetMotorCurrentLimit();
+        servo_.SetCurrentLimit(resistance, currentLimit);
+        current.SetMotorModel(resistance, currentLimit);
         servo_.Update(batteryVoltage, velo.trans, velo.rot);
-        if (servo_.IsEmergency()) {
+        /* 内側ループの割り込みは1周期に何回も届くはず (止まるとデューティが更新されない) */
+        uint32_t updateCount = current.GetUpdateCount();
+        if (updateCount == currentUpdateCount) {
+          fault.Raise(FaultCode::kCurrentLoop);
+        }
+        currentUpdateCount = updateCount;
+        if (servo_.IsEmergency() || fault.IsStopRequired()) {
+          current.Disable();
           motor.Disable();
+        } else if (servo_.IsActiveBrake()) {
+          /* 短絡ブレーキ (逆起電力 / 抵抗 が許容電流を超える速度ではブレーキ時間を減らす) */
+          if (!braking) {
+            current.Disable();
+            braking = true;
+          }
+          auto omega = encoder.GetVelocity();
+          Motor::Duty ratio{};
+          for (int i = 0; i < 2; i++) {
+            float backEmf = std::abs(kBackEmfPerVelocity * omega[i] * kWheelRadius);
+            float allowance = currentLimit[i] * resistance[i];
+            ratio[i] = backEmf > allowance ? allowance / backEmf : 1.0f;
+          }
+          motor.SetBrake(ratio);
         } else {
-          motor.SetDuty(servo_.GetMotorDuty());
+          if (braking) {
+            current.Enable();
+            braking = false;
+          }
+          /* 速度サーボの電圧指令を電流指令に変換して内側ループへ渡す */
+          motor.SetDecay(servo_.GetDecay());
+          current.SetVoltageReference(servo_.GetMotorVoltage(), encoder.GetVelocity(), batteryVoltage);
         }
+        /* バッテリーモデルの推定用 (短絡ブレーキ中はバッテリーから流れない) */
+        powerMonitoring.SetMotorVoltage(braking ? ServoImpl::ControlAmount{} : servo_.GetMotorVoltage());
       }
     }
   }
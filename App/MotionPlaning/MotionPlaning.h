@@ -18,6 +18,12 @@ class MotionPlaning final : public Task<MotionPlaning> {
   /* サーボを取得 */
   ServoImpl &Servo() { return servo_; }
 
+  /* 不揮発メモリから摩擦補償を読み込み */
+  bool LoadFriction();
+  /* 摩擦補償を設定して不揮発メモリに保存 */
+  bool StoreFriction(const ServoImpl::ControlAmount &breakaway, const ServoImpl::ControlAmount &coulomb,
+                     const ServoImpl::ControlAmount &viscous);
+
  protected:
   /* タスク */
   void TaskEntry() final;
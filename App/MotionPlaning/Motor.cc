@@ -25,27 +25,65 @@ bool Motor::Initialize() {
 /* 有効化 */
 void Motor::Enable() { HAL_GPIO_WritePin(DRV_EN_GPIO_Port, DRV_EN_Pin, GPIO_PIN_SET); }
 void Motor::Disable() { HAL_GPIO_WritePin(DRV_EN_GPIO_Port, DRV_EN_Pin, GPIO_PIN_RESET); }
+bool Motor::IsEnabled() { return HAL_GPIO_ReadPin(DRV_EN_GPIO_Port, DRV_EN_Pin) == GPIO_PIN_SET; }
 
 /* フォールトを取得 */
-bool Motor::IsFault() { return HAL_GPIO_ReadPin(DRV_NFAULT_GPIO_Port, DRV_NFAULT_Pin) != GPIO_PIN_RESET; }
+bool Motor::IsFault() { return HAL_GPIO_ReadPin(DRV_NFAULT_GPIO_Port, DRV_NFAULT_Pin) == GPIO_PIN_RESET; }
 
 /* ブレーキ */
 void Motor::Brake() {
   for (int i = 0; i < 4; i++) {
     __HAL_TIM_SET_COMPARE(&htim1, channels[i], 0);
+    residual_[i] = 0.0f;
   }
 }
 
+/* 減衰モードを設定 */
+void Motor::SetDecay(Decay decay) { decay_ = decay; }
+
 /* デューティ設定 */
+/* 中央揃えPWMなので、両入力がHighの区間(ブレーキ)は駆動側がHighの区間の中央に入る */
+/* 駆動側 = 駆動 + ブレーキ、反対側 = ブレーキ、残りは両方Lowで惰性 */
 void Motor::SetDuty(const Duty &duty) {
   for (int i = 0; i < 2; i++) {
     if (std::isfinite(duty[i])) {
       bool ccw = std::signbit(duty[i]);
-      uint32_t dutyNum = static_cast<uint32_t>(static_cast<float>(htim1.Init.Period) * std::abs(duty[i]));
-      uint32_t clampDutyNum = std::min(std::max(0ul, dutyNum), htim1.Init.Period);
-      __HAL_TIM_SET_COMPARE(&htim1, channels[2 * i], ccw ? clampDutyNum : 0);
-      __HAL_TIM_SET_COMPARE(&htim1, channels[2 * i + 1], ccw ? 0 : clampDutyNum);
+      float drive = std::min(std::abs(duty[i]), 1.0f);
+      float brake = 0.0f;
+      if (decay_ == Decay::kSlow) {
+        brake = 1.0f - drive;
+      } else if (decay_ == Decay::kMixed) {
+        brake = (1.0f - drive) * kMotorMixedDecayRatio;
+      }
+      SetCompare(2 * i, ccw ? drive + brake : brake);
+      SetCompare(2 * i + 1, ccw ? brake : drive + brake);
     }
   }
 }
+
+/* 短絡ブレーキ */
+void Motor::SetBrake(const Duty &ratio) {
+  for (int i = 0; i < 2; i++) {
+    if (std::isfinite(ratio[i])) {
+      float brake = std::clamp(ratio[i], 0.0f, 1.0f);
+      SetCompare(2 * i, brake);
+      SetCompare(2 * i + 1, brake);
+    }
+  }
+}
+
+/* コンペア値を設定 */
+/* 1カウント未満の端数を切り捨てず次の更新に繰り越す1次ΣΔ変調で、平均のデューティを分解能以下まで合わせる */
+/* 更新は電流制御周期(繰り返しカウンタで数PWM周期ごと)なので、揺らぎは電流制御の積分とモーターのインダクタンスで均される */
+void Motor::SetCompare(int index, float ratio) {
+  float period = static_cast<float>(htim1.Init.Period);
+  float target = period * ratio;
+  if constexpr (kMotorPwmDithering) {
+    target += residual_[index];
+  }
+  float count = std::clamp(std::floor(target), 0.0f, period);
+  /* 上下限で飽和した分は繰り越さない */
+  residual_[index] = kMotorPwmDithering ? std::clamp(target - count, 0.0f, 1.0f) : 0.0f;
+  __HAL_TIM_SET_COMPARE(&htim1, channels[index], static_cast<uint32_t>(count));
+}
 }  // namespace MotionPlaning
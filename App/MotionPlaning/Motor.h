@@ -2,6 +2,7 @@
 #define MOTIONPLANING_MOTOR_H_
 
 /* Project */
+#include "Config.h"
 #include "Data/Singleton.h"
 
 /* C++ */
@@ -12,21 +13,42 @@ class Motor final : public Singleton<Motor> {
  public:
   using Duty = std::array<float, 2>;
 
+  /* 減衰モード (PWMのオフ期間にモーター電流をどう流すか) */
+  enum class Decay {
+    kFast,  /* 惰性: 電流は速く減衰するが、逆起電力より低い電圧では減速できない */
+    kSlow,  /* 短絡ブレーキ: 電流はゆっくり減衰し、デューティに比例した電圧で加減速できる */
+    kMixed, /* オフ期間の kMotorMixedDecayRatio をブレーキ、残りを惰性 */
+  };
+
   /* 初期化 */
   bool Initialize();
 
   /* 有効化 */
   void Enable();
   void Disable();
+  bool IsEnabled();
 
-  /* フォールトを取得 */
+  /* フォールトを取得 (nFAULTはLowでフォールト) */
   bool IsFault();
 
   /* ブレーキ */
   void Brake();
 
+  /* 減衰モードを設定 (次のデューティ設定から反映) */
+  void SetDecay(Decay decay);
+
   /* デューティを設定 */
   void SetDuty(const Duty &duty);
+
+  /* 短絡ブレーキ (ブレーキする時間の割合、残りは惰性で電流を制限する) */
+  void SetBrake(const Duty &ratio);
+
+ private:
+  volatile Decay decay_{Decay::kFast};
+  std::array<float, 4> residual_{}; /* チャンネルごとに繰り越したコンペア値の端数 */
+
+  /* コンペア値を設定 (kMotorPwmDithering なら端数を繰り越す) */
+  void SetCompare(int index, float ratio);
 };
 }  // namespace MotionPlaning
 
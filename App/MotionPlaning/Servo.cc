@@ -3,6 +3,7 @@
 /* プロジェクト */
 #include "Config.h"
 #include "Data/Pid.h"
+#include "FaultManager.h"
 
 /* C++ */
 #include <algorithm>
@@ -12,9 +13,19 @@
 namespace MotionPlaning {
 /* ゲインを設定 */
 void ServoImpl::SetGain(const Pid::Gain &linear, const Pid::Gain &angular) {
+  SetGainSchedule(PidGainSchedule::Constant(linear), PidGainSchedule::Constant(angular));
+}
+
+/* 速度でスケジュールするゲインを設定 */
+void ServoImpl::SetGainSchedule(const PidGainSchedule &linear, const PidGainSchedule &angular) {
   std::scoped_lock<Mutex> lock(mtx_);
-  pidLinear_.Reset(linear);
-  pidAngular_.Reset(angular);
+  linearSchedule_ = linear;
+  angularSchedule_ = angular;
+  pidLinear_.Reset(linear.Get(0.0f));
+  pidAngular_.Reset(angular.Get(0.0f));
+  /* 目標値変化で微分キックが出ないよう微分は計測値のみにかける */
+  pidLinear_.SetSetpointWeight(1.0f, 0.0f);
+  pidAngular_.SetSetpointWeight(1.0f, 0.0f);
 }
 
 /* 目標値を設定 */
@@ -24,6 +35,44 @@ void ServoImpl::SetTarget(float linear, float angular) {
   targetAngular_ = angular;
 }
 
+/* 減衰モードを設定 */
+void ServoImpl::SetDecay(Motor::Decay decay) {
+  std::scoped_lock<Mutex> lock(mtx_);
+  decay_ = decay;
+}
+/* 減衰モードを取得 */
+Motor::Decay ServoImpl::GetDecay() {
+  std::scoped_lock<Mutex> lock(mtx_);
+  return decay_;
+}
+
+/* 電流制限付き短絡ブレーキに切り替える */
+void ServoImpl::SetActiveBrake(bool enable) {
+  std::scoped_lock<Mutex> lock(mtx_);
+  activeBrake_ = enable;
+}
+/* 短絡ブレーキ中か */
+bool ServoImpl::IsActiveBrake() {
+  std::scoped_lock<Mutex> lock(mtx_);
+  return activeBrake_;
+}
+
+/* 摩擦補償を設定 */
+void ServoImpl::SetFriction(const ControlAmount &breakaway, const ControlAmount &coulomb,
+                            const ControlAmount &viscous) {
+  std::scoped_lock<Mutex> lock(mtx_);
+  frictionBreakaway_ = breakaway;
+  frictionCoulomb_ = coulomb;
+  frictionViscous_ = viscous;
+}
+
+/* 温度で低減した許容電流を設定 */
+void ServoImpl::SetCurrentLimit(const ControlAmount &resistance, const ControlAmount &currentLimit) {
+  std::scoped_lock<Mutex> lock(mtx_);
+  resistance_ = resistance;
+  currentLimit_ = currentLimit;
+}
+
 /* リセット */
 void ServoImpl::Reset() {
   std::scoped_lock<Mutex> lock(mtx_);
@@ -34,6 +83,8 @@ void ServoImpl::Reset() {
   isEmergency_ = false;
   errorLinearTime_ = 0;
   errorAngularTime_ = 0;
+  decay_ = Motor::Decay::kFast;
+  activeBrake_ = false;
 }
 
 /* 更新 */
@@ -78,28 +129,61 @@ void ServoImpl::Update(float batteryVoltage, /* バッテリー電圧 [V] */
   //     kMotorBackEmf * feedforwardWheelOmega_[1],
   // };
 
-  /* フィードバック制御 */
+  /* フィードバック制御 (出力できる電圧で制限して積分の飽和を防ぐ) */
+  float limit = std::min(kMotorLimitVoltage, batteryVoltage);
+  pidLinear_.SetLimit(-limit, limit);
+  pidAngular_.SetLimit(-limit, limit);
+  pidLinear_.SetGain(linearSchedule_.Get(std::abs(measureLinear)));
+  pidAngular_.SetGain(angularSchedule_.Get(std::abs(measureLinear)));
   feedback_ = {
-      pidLinear_.Update(targetLinear_, measureLinear, 1.0f),
-      pidAngular_.Update(targetAngular_, measureAngular, 1.0f),
+      pidLinear_.Update(targetLinear_, measureLinear),
+      pidAngular_.Update(targetAngular_, measureAngular),
   };
 
+  /* 摩擦補償 (止まっている車輪は起動電圧、回っている車輪はクーロン摩擦と粘性摩擦を打ち消す) */
+  {
+    ControlAmount targetWheel = {
+        targetLinear_ + targetAngular_ * W / 2.0f,
+        targetLinear_ - targetAngular_ * W / 2.0f,
+    };
+    ControlAmount measureWheel = {
+        measureLinear + measureAngular * W / 2.0f,
+        measureLinear - measureAngular * W / 2.0f,
+    };
+    for (int i = 0; i < 2; i++) {
+      /* 目標が0付近では補償を弱めて停止時に振動しないようにする */
+      float direction = std::clamp(targetWheel[i] / kFrictionVelocityThreshold, -1.0f, 1.0f);
+      float coulomb =
+          std::abs(measureWheel[i]) < kFrictionStaticVelocity ? frictionBreakaway_[i] : frictionCoulomb_[i];
+      feedforward_[i] = direction * coulomb + frictionViscous_[i] * targetWheel[i];
+    }
+  }
+
   /* 電圧に換算 */
-  // voltage_ = {
-  //     feedforward_[0] + feedback_[0] + feedback_[1],
-  //     feedforward_[1] + feedback_[0] - feedback_[1],
-  // };
   voltage_ = {
-      feedback_[0] + feedback_[1],
-      feedback_[0] - feedback_[1],
+      feedforward_[0] + feedback_[0] + feedback_[1],
+      feedforward_[1] + feedback_[0] - feedback_[1],
   };
 
   /* NaN・Infを弾く */
   if (!std::isfinite(voltage_[0]) || !std::isfinite(voltage_[1])) {
+    FaultManager::Instance().Raise(FaultCode::kServoInvalid);
     isEmergency_ = true;
     return;
   }
 
+  /* 許容電流を超えない電圧に丸める (逆起電力は計測速度から求める) */
+  {
+    ControlAmount backEmf = {
+        kBackEmfPerVelocity * (measureLinear + measureAngular * W / 2.0f),
+        kBackEmfPerVelocity * (measureLinear - measureAngular * W / 2.0f),
+    };
+    for (int i = 0; i < 2; i++) {
+      float margin = currentLimit_[i] * resistance_[i];
+      voltage_[i] = std::clamp(voltage_[i], backEmf[i] - margin, backEmf[i] + margin);
+    }
+  }
+
   /* 上限電圧で丸める */
   for (auto &voltage : voltage_) {
     voltage = std::copysign(std::min(std::abs(voltage), std::min(kMotorLimitVoltage, batteryVoltage)), voltage);
@@ -113,6 +197,7 @@ void ServoImpl::Update(float batteryVoltage, /* バッテリー電圧 [V] */
   /* エラー判定 */
   if (std::abs(measureLinear) < std::abs(targetLinear_ * kServoErrorLinearGain)) {
     if (++errorLinearTime_ >= kServoErrorLinearTime) {
+      FaultManager::Instance().Raise(FaultCode::kServoLinear);
       isEmergency_ = true;
     }
   } else {
@@ -120,6 +205,7 @@ void ServoImpl::Update(float batteryVoltage, /* バッテリー電圧 [V] */
   }
   if (std::abs(measureAngular) < std::abs(targetAngular_ * kServoErrorAngularGain)) {
     if (++errorAngularTime_ >= kServoErrorAngularTime) {
+      FaultManager::Instance().Raise(FaultCode::kServoAngular);
       isEmergency_ = true;
     }
   } else {
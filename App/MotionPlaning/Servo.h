@@ -6,6 +6,7 @@
 
 /* Project */
 #include "Data/Pid.h"
+#include "MotionPlaning/Motor.h"
 #include "Wrapper/Mutex.h"
 
 namespace MotionPlaning {
@@ -15,10 +16,33 @@ class ServoImpl {
 
   /* ゲインを設定 */
   void SetGain(const Pid::Gain &linear, const Pid::Gain &angular);
+  /* 速度でスケジュールするゲインを設定 */
+  void SetGainSchedule(const PidGainSchedule &linear, const PidGainSchedule &angular);
 
   /* 目標値を設定 */
   void SetTarget(float linear, float angular);
 
+  /* 減衰モードを設定 (減速中は短絡ブレーキで制動力を確保する) */
+  void SetDecay(Motor::Decay decay);
+  /* 減衰モードを取得 */
+  Motor::Decay GetDecay();
+
+  /* 電流制限付き短絡ブレーキに切り替える (サーボの電圧指令を使わない) */
+  void SetActiveBrake(bool enable);
+  /* 短絡ブレーキ中か */
+  bool IsActiveBrake();
+
+  /* 摩擦補償を設定 */
+  void SetFriction(const ControlAmount &breakaway, /* 起動電圧 [V] */
+                   const ControlAmount &coulomb,   /* クーロン摩擦電圧 [V] */
+                   const ControlAmount &viscous    /* 粘性摩擦係数 [V/(m/s)] */
+  );
+
+  /* 温度で低減した許容電流を設定 (逆起電力 ± 許容電流 × 抵抗に電圧を制限する) */
+  void SetCurrentLimit(const ControlAmount &resistance,  /* モーター抵抗 [Ω] */
+                       const ControlAmount &currentLimit /* 許容電流 [A] */
+  );
+
   /* リセット */
   void Reset();
 
@@ -49,6 +73,8 @@ class ServoImpl {
 
   Pid pidLinear_;
   Pid pidAngular_;
+  PidGainSchedule linearSchedule_{};
+  PidGainSchedule angularSchedule_{};
 
   float targetLinear_;
   float targetAngular_;
@@ -60,6 +86,16 @@ class ServoImpl {
   ControlAmount voltage_{};
   ControlAmount duty_{};
 
+  Motor::Decay decay_{Motor::Decay::kFast};
+  bool activeBrake_{false};
+
+  ControlAmount frictionBreakaway_{kFrictionBreakawayVoltage, kFrictionBreakawayVoltage};
+  ControlAmount frictionCoulomb_{kFrictionCoulombVoltage, kFrictionCoulombVoltage};
+  ControlAmount frictionViscous_{kFrictionViscousVoltage, kFrictionViscousVoltage};
+
+  ControlAmount resistance_{kMotorResistance, kMotorResistance};
+  ControlAmount currentLimit_{kMotorCurrentLimit, kMotorCurrentLimit};
+
   uint32_t errorLinearTime_;
   uint32_t errorAngularTime_;
   bool isEmergency_;
@@ -1,47 +1,192 @@
 #include "MotionPlaning/VelocityGenerator.h"
 
 /* C++ */
+#include <algorithm>
 #include <cmath>
 
-/* 計算 */
-void SlopeVelocityGenerator::Generate(const Profile &profile) {
-  profile_ = profile;
-  if (std::abs(profile_.distance) > 0.0f) {
-    /* 移動距離がが定まっている場合 */
-    t0_ = (profile_.maxVelocity - profile_.startVelocity) / profile_.acceleration;
-    float x0 = profile_.startVelocity * t0_ + (profile_.acceleration * powf(t0_, 2)) / 2.0f;
-    t2_ = (profile_.endVelocity - profile_.maxVelocity) / profile_.deceleration;
-    float x2 = profile_.maxVelocity * t2_ + (profile_.deceleration * powf(t2_, 2)) / 2.0f;
-    float x1 = profile_.distance - x0 - x2;
-    t1_ = x1 / profile_.maxVelocity;
-  }
-}
-/* 時刻tにおける速度を取得 */
-float SlopeVelocityGenerator::GetVelocity(uint32_t ms) {
-  float t = static_cast<float>(ms) / 1000.0f;
-  if (t < t0_) {
-    return profile_.startVelocity + profile_.acceleration * t;
-  } else if (t < (t0_ + t1_)) {
-    return profile_.maxVelocity;
-  } else if (t < (t0_ + t1_ + t2_)) {
-    return profile_.maxVelocity + profile_.deceleration * (t - (t0_ + t1_));
-  }
-  return 0.0f;
-}
-
-/* 加速時間を取得 */
-uint32_t SlopeVelocityGenerator::GetAccelerationTime() { return static_cast<uint32_t>(t0_ * 1000.0f); }
-/* 加速距離を取得 */
-float SlopeVelocityGenerator::GetAccelerationDistance() { return x0_; }
-/* 等速時間を取得 */
-uint32_t SlopeVelocityGenerator::GetConstantSpeedTime() { return static_cast<uint32_t>(t1_ * 1000.0f); }
-/* 等速距離を取得 */
-float SlopeVelocityGenerator::GetConstantSpeedDistance() { return x1_; }
-/* 減速時間を取得 */
-uint32_t SlopeVelocityGenerator::GetDecelerationTime() { return static_cast<uint32_t>(t2_ * 1000.0f); }
-/* 減速距離を取得 */
-float SlopeVelocityGenerator::GetDecelerationDistance() { return x2_; }
+/* 開始速度を設定して区間をクリア */
+void SCurveVelocityGenerator::Reset(float startVelocity) {
+  numSegments_ = 0;
+  cursor_ = 0;
+  endTime_ = 0.0f;
+  end_ = {0.0f, startVelocity, 0.0f};
+}
+
+/* 速度遷移を追加 */
+bool SCurveVelocityGenerator::AddTransition(float targetVelocity, float acceleration, float jerk) {
+  float dv = targetVelocity - end_.velocity;
+  if (dv == 0.0f) {
+    return true;
+  }
+  if (acceleration <= 0.0f || jerk <= 0.0f || numSegments_ + 3 > kMaxSegments) {
+    return false;
+  }
+  float sign = std::copysign(1.0f, dv);
+  dv = std::abs(dv);
+  /* 加速度上限に達する場合は躍度0の区間を挟む */
+  float jerkTime = acceleration / jerk;
+  float constantTime = dv / acceleration - jerkTime;
+  if (constantTime < 0.0f) {
+    jerkTime = std::sqrt(dv / jerk);
+    constantTime = 0.0f;
+  }
+  float velocity = targetVelocity;
+  bool result = AddSegment(sign * jerk, jerkTime) && AddSegment(0.0f, constantTime) &&
+                AddSegment(-1.0f * sign * jerk, jerkTime);
+  /* 丸め誤差を残さない */
+  end_.acceleration = 0.0f;
+  end_.velocity = velocity;
+  return result;
+}
+
+/* 等速区間を追加 */
+bool SCurveVelocityGenerator::AddConstant(float distance) {
+  if (distance <= 0.0f) {
+    return true;
+  }
+  if (end_.velocity <= 0.0f) {
+    return false;
+  }
+  return AddSegment(0.0f, distance / end_.velocity);
+}
+
+/* 加速・等速・減速のプロファイルを生成 */
+bool SCurveVelocityGenerator::Generate(const Profile &profile) {
+  Reset(profile.startVelocity);
+  float accel = std::abs(profile.acceleration);
+  float decel = std::abs(profile.deceleration);
+  auto required = [&](float velocity) {
+    return TransitionDistance(profile.startVelocity, velocity, accel, profile.jerk) +
+           TransitionDistance(velocity, profile.endVelocity, decel, profile.jerk);
+  };
+  float lower = std::max(profile.startVelocity, profile.endVelocity);
+  float maxVelocity = std::max(profile.maxVelocity, lower);
+  if (required(lower) > profile.distance) {
+    /* 開始速度から終了速度への遷移だけでも距離が足りない */
+    AddTransition(profile.endVelocity, std::max(accel, decel), profile.jerk);
+    return false;
+  }
+  if (required(maxVelocity) > profile.distance) {
+    /* 二分法で到達できる最大速度を求める */
+    float upper = maxVelocity;
+    for (int i = 0; i < 24; i++) {
+      float middle = (lower + upper) / 2.0f;
+      if (required(middle) > profile.distance) {
+        upper = middle;
+      } else {
+        lower = middle;
+      }
+    }
+    maxVelocity = lower;
+  }
+  return AddTransition(maxVelocity, accel, profile.jerk) && AddConstant(profile.distance - required(maxVelocity)) &&
+         AddTransition(profile.endVelocity, decel, profile.jerk);
+}
+
+/* 時刻 t における状態を取得 */
+SCurveVelocityGenerator::State SCurveVelocityGenerator::GetStateAtTime(float t) {
+  if (numSegments_ == 0 || t >= endTime_) {
+    /* 終了後は終了速度のまま進む */
+    float over = std::max(t - endTime_, 0.0f);
+    return {0.0f, end_.velocity, end_.distance + end_.velocity * over};
+  }
+  t = std::max(t, 0.0f);
+  while (cursor_ > 0 && t < segments_[cursor_].startTime) {
+    cursor_--;
+  }
+  while (cursor_ + 1 < numSegments_ && t >= segments_[cursor_ + 1].startTime) {
+    cursor_++;
+  }
+  const auto &segment = segments_[cursor_];
+  return Evaluate(segment, t - segment.startTime);
+}
+
+/* 距離 x における状態を取得 */
+SCurveVelocityGenerator::State SCurveVelocityGenerator::GetStateAtDistance(float x) {
+  if (numSegments_ == 0 || x >= end_.distance) {
+    return {0.0f, end_.velocity, std::max(x, end_.distance)};
+  }
+  x = std::max(x, 0.0f);
+  while (cursor_ > 0 && x < segments_[cursor_].start.distance) {
+    cursor_--;
+  }
+  while (cursor_ + 1 < numSegments_ && x >= segments_[cursor_ + 1].start.distance) {
+    cursor_++;
+  }
+  /* 区間内の距離は時間の3次式なので、範囲を狭めながらニュートン法で解く */
+  const auto &segment = segments_[cursor_];
+  float lower = 0.0f, upper = segment.duration;
+  float tau = segment.start.velocity > 0.0f ? (x - segment.start.distance) / segment.start.velocity : upper / 2.0f;
+  tau = std::clamp(tau, lower, upper);
+  auto state = Evaluate(segment, tau);
+  for (int i = 0; i < 16; i++) {
+    float error = state.distance - x;
+    if (std::abs(error) < 1e-6f) {
+      break;
+    }
+    if (error > 0.0f) {
+      upper = tau;
+    } else {
+      lower = tau;
+    }
+    tau = state.velocity > 0.0f ? tau - error / state.velocity : lower;
+    if (tau <= lower || tau >= upper) {
+      tau = (lower + upper) / 2.0f;
+    }
+    state = Evaluate(segment, tau);
+  }
+  return state;
+}
+
+/* 時刻における速度を取得 */
+float SCurveVelocityGenerator::GetVelocity(uint32_t ms) {
+  return GetStateAtTime(static_cast<float>(ms) / 1000.0f).velocity;
+}
+
 /* 走行時間を取得 */
-uint32_t SlopeVelocityGenerator::GetTotalTime() { return static_cast<uint32_t>((t0_ + t1_ + t2_) * 1000.0f); }
+uint32_t SCurveVelocityGenerator::GetTotalTime() const { return static_cast<uint32_t>(endTime_ * 1000.0f); }
 /* 走行距離を取得 */
-float SlopeVelocityGenerator::GetTotalDistance() { return (x0_ + x1_ + x2_); }
+float SCurveVelocityGenerator::GetTotalDistance() const { return end_.distance; }
+
+/* 速度遷移に必要な時間を取得 */
+float SCurveVelocityGenerator::TransitionTime(float startVelocity, float endVelocity, float acceleration,
+                                              float jerk) {
+  float dv = std::abs(endVelocity - startVelocity);
+  if (acceleration <= 0.0f || jerk <= 0.0f) {
+    return 0.0f;
+  }
+  if (dv * jerk >= acceleration * acceleration) {
+    return dv / acceleration + acceleration / jerk;
+  }
+  return 2.0f * std::sqrt(dv / jerk);
+}
+/* 速度遷移に必要な距離を取得 (加速度波形が対称なので平均速度は始点と終点の平均) */
+float SCurveVelocityGenerator::TransitionDistance(float startVelocity, float endVelocity, float acceleration,
+                                                  float jerk) {
+  return (startVelocity + endVelocity) / 2.0f * TransitionTime(startVelocity, endVelocity, acceleration, jerk);
+}
+
+/* 区間を追加 */
+bool SCurveVelocityGenerator::AddSegment(float jerk, float duration) {
+  if (duration <= 0.0f) {
+    return true;
+  }
+  if (numSegments_ >= kMaxSegments) {
+    return false;
+  }
+  auto &segment = segments_[numSegments_++];
+  segment = {endTime_, duration, jerk, end_};
+  end_ = Evaluate(segment, duration);
+  endTime_ += duration;
+  return true;
+}
+
+/* 区間内の経過時間 tau における状態 */
+SCurveVelocityGenerator::State SCurveVelocityGenerator::Evaluate(const Segment &segment, float tau) {
+  const auto &s = segment.start;
+  return {
+      s.acceleration + segment.jerk * tau,
+      s.velocity + s.acceleration * tau + segment.jerk * tau * tau / 2.0f,
+      s.distance + s.velocity * tau + s.acceleration * tau * tau / 2.0f + segment.jerk * tau * tau * tau / 6.0f,
+  };
+}
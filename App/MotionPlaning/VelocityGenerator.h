@@ -2,45 +2,77 @@
 #define MOTIONPLANING_VELOCITYGENERATOR_H_
 
 /* C++ */
+#include <array>
 #include <cstdint>
 
-class SlopeVelocityGenerator {
+/* 躍度制限付き(S字)速度プロファイル */
+/* 躍度一定の区間を連結して保持し、時刻・距離のどちらでも評価できる */
+/* 評価位置は直前の区間から探すので、単調に進める場合は1回あたり定数時間 */
+class SCurveVelocityGenerator {
  public:
+  static constexpr uint32_t kMaxSegments = 16; /* 最大区間数 */
+
   struct Profile {
     float startVelocity; /* 開始速度 [m/s] */
     float maxVelocity;   /* 最大速度 [m/s] */
     float endVelocity;   /* 終了速度 [m/s] */
     float acceleration;  /* 加速度 [m/s^2] */
-    float deceleration;  /* 減速度 [m/s^2] */
+    float deceleration;  /* 減速度 [m/s^2] (大きさ) */
+    float jerk;          /* 躍度 [m/s^3] */
     float distance;      /* 移動距離 [m] */
   };
+  struct State {
+    float acceleration; /* 加速度 [m/s^2] */
+    float velocity;     /* 速度 [m/s] */
+    float distance;     /* 距離 [m] */
+  };
+
+  /* 開始速度を設定して区間をクリア */
+  void Reset(float startVelocity);
+  /* 速度遷移を追加 (加速度0から始まり加速度0で終わる) */
+  bool AddTransition(float targetVelocity, float acceleration, float jerk);
+  /* 等速区間を追加 */
+  bool AddConstant(float distance);
+
+  /* 加速・等速・減速のプロファイルを生成 (距離が足りない場合は最大速度を下げる) */
+  bool Generate(const Profile &profile);
 
-  /* 計算 */
-  void Generate(const Profile &profile);
-  /* 時刻tにおける速度を取得 */
+  /* 時刻 t [s] における状態を取得 */
+  State GetStateAtTime(float t);
+  /* 距離 x [m] における状態を取得 */
+  State GetStateAtDistance(float x);
+  /* 時刻 [ms] における速度を取得 */
   float GetVelocity(uint32_t ms);
 
-  /* 加速時間を取得 */
-  uint32_t GetAccelerationTime();
-  /* 加速距離を取得 */
-  float GetAccelerationDistance();
-  /* 等速時間を取得 */
-  uint32_t GetConstantSpeedTime();
-  /* 等速距離を取得 */
-  float GetConstantSpeedDistance();
-  /* 減速時間を取得 */
-  uint32_t GetDecelerationTime();
-  /* 減速距離を取得 */
-  float GetDecelerationDistance();
-  /* 走行時間を取得 */
-  uint32_t GetTotalTime();
-  /* 走行距離を取得 */
-  float GetTotalDistance();
+  /* 走行時間を取得 [ms] */
+  uint32_t GetTotalTime() const;
+  /* 走行距離を取得 [m] */
+  float GetTotalDistance() const;
+
+  /* 速度遷移に必要な時間を取得 [s] */
+  static float TransitionTime(float startVelocity, float endVelocity, float acceleration, float jerk);
+  /* 速度遷移に必要な距離を取得 [m] */
+  static float TransitionDistance(float startVelocity, float endVelocity, float acceleration, float jerk);
 
  private:
-  float t0_, t1_, t2_;
-  float x0_, x1_, x2_;
-  Profile profile_;
+  /* 躍度一定の区間 (開始時の状態を保持) */
+  struct Segment {
+    float startTime; /* 開始時刻 [s] */
+    float duration;  /* 時間 [s] */
+    float jerk;      /* 躍度 [m/s^3] */
+    State start;     /* 開始時の状態 */
+  };
+
+  std::array<Segment, kMaxSegments> segments_{};
+  uint32_t numSegments_{0};
+  uint32_t cursor_{0}; /* 前回評価した区間 */
+  float endTime_{0.0f};
+  State end_{};
+
+  /* 区間を追加 */
+  bool AddSegment(float jerk, float duration);
+  /* 区間内の経過時間 tau [s] における状態 */
+  static State Evaluate(const Segment &segment, float tau);
 };
 
 #endif  // MOTIONPLANING_VELOCITYGENERATOR_H_
@@ -83,7 +83,8 @@ bool VelocityMapping::CalculatVelocityTable(const std::vector<float> &minRadiusV
                                             const std::vector<float> &maxVelocityVec, /* 半径における並進速度[m/s] */
                                             float startVelo,                          /* 開始速度 [m/s] */
                                             float accel,                              /* 加速度 [m/ss] */
-                                            float decel                               /* 減速度 [m/ss] */
+                                            float decel,                              /* 減速度 [m/ss] */
+                                            const DriveLimit &limit                   /* 電源・モーターの状態 */
 ) {
   if (minRadiusVec.size() != minRadiusVec.size()) {
     return false;
@@ -117,12 +118,13 @@ bool VelocityMapping::CalculatVelocityTable(const std::vector<float> &minRadiusV
       }
     }
   }
-  /* 加速 */
+  /* 加速 (電圧と許容電流で出せる加速度に制限) */
   for (uint32_t point = 0; point < static_cast<uint16_t>(numSearchRunningPoints_ - 1); point++) {
     if (velocityVec_[point] < velocityVec_[point + 1]) { /* now < next */
-      auto s = (std::pow(velocityVec_[point + 1], 2) - std::pow(velocityVec_[point], 2)) / (2.0f * accel);
+      auto a = std::max(std::min(accel, AchievableAcceleration(velocityVec_[point], limit)), 0.0f);
+      auto s = (std::pow(velocityVec_[point + 1], 2) - std::pow(velocityVec_[point], 2)) / (2.0f * a);
       if (s > deltaDistanceArray_[point + 1]) {
-        auto fix = velocityVec_[point] + deltaDistanceArray_[point] * accel;
+        auto fix = velocityVec_[point] + deltaDistanceArray_[point] * a;
         velocityVec_[point + 1] = std::min(fix, maxVelocityVec.back());
       }
     }
@@ -130,15 +132,60 @@ bool VelocityMapping::CalculatVelocityTable(const std::vector<float> &minRadiusV
   hasVelocityTable_ = true;
   return true;
 }
+/* 電圧と許容電流で出せる加速度 */
+float VelocityMapping::AchievableAcceleration(float velocity, const DriveLimit &limit) {
+  float current = limit.motorCurrentLimit;
+  if (limit.openCircuitVoltage > 0.0f) {
+    /* モーター電圧 = 抵抗 × 電流 + 逆起電力、バッテリーからは両輪分の電流が流れる */
+    float voltage = kPlanningVoltageRatio * limit.openCircuitVoltage - kBackEmfPerVelocity * velocity;
+    current = std::min(current, voltage / (limit.motorResistance + 2.0f * limit.internalResistance));
+  }
+  return kForcePerCurrent * current;
+}
 /* 速度テーブルをリセット */
 void VelocityMapping::ResetVelocityTable() {
   velocityVec_.clear();
+  suctionVec_.clear();
   hasVelocityTable_ = false;
 }
 /* 速度テーブルがあるか */
 bool VelocityMapping::HasVelocityTable() { return hasVelocityTable_; }
 /* 速度テーブルを取得 */
 const std::vector<float> &VelocityMapping ::GetVelocityTable() { return velocityVec_; }
+/* 速度テーブルから区間ごとの吸引電圧を計算 */
+bool VelocityMapping::CalculateSuctionTable(float minVoltage, /* 直線での吸引電圧 [V] */
+                                            float maxVoltage  /* カーブ・加減速での吸引電圧 [V] */
+) {
+  auto num = std::min(static_cast<uint32_t>(velocityVec_.size()), static_cast<uint32_t>(numSearchRunningPoints_));
+  suctionVec_.assign(num, maxVoltage);
+  if (num == 0) {
+    return false;
+  }
+  /* 区間で必要な加速度 (曲率と速度からの横加速度と、速度テーブルの前後加速度の合成) */
+  /* 吸引力は電圧の2乗に比例するとして、加速度に見合う吸引力になる電圧を求める */
+  std::vector<float> required(num, maxVoltage);
+  for (uint32_t point = 0; point < num; point++) {
+    auto velocity = velocityVec_[point];
+    auto distance = std::max(deltaDistanceArray_[point], kMappingDistance);
+    auto lateral = velocity * velocity * std::abs(deltaAngleArray_[point]) / distance;
+    auto next = velocityVec_[std::min(point + 1, num - 1)];
+    auto longitudinal = std::abs(next * next - velocity * velocity) / (2.0f * distance);
+    auto ratio = std::min(std::hypot(lateral, longitudinal) / kSuctionFullAcceleration, 1.0f);
+    required[point] = std::sqrt(minVoltage * minVoltage + (maxVoltage * maxVoltage - minVoltage * minVoltage) * ratio);
+  }
+  /* ファンの立ち上がり時間分だけ先の区間で必要な電圧を前倒しする */
+  for (uint32_t point = 0; point < num; point++) {
+    auto lead = velocityVec_[point] * kSuctionLeadTime;
+    auto voltage = required[point];
+    float distance = 0.0f;
+    for (uint32_t ahead = point + 1; ahead < num && distance < lead; ahead++) {
+      voltage = std::max(voltage, required[ahead]);
+      distance += deltaDistanceArray_[ahead];
+    }
+    suctionVec_[point] = voltage;
+  }
+  return true;
+}
 
 /* 最短走行リセット */
 void VelocityMapping::ResetFastRunning() {
@@ -148,6 +195,16 @@ void VelocityMapping::ResetFastRunning() {
 
   fastCrossLinePoint_ = 0;
   fastCurveMarkerPoint_ = 0;
+  fastGoalDistance_ = 0.0f;
+  for (uint16_t point = 0; point < numSearchRunningPoints_; point++) {
+    fastGoalDistance_ += deltaDistanceArray_[point];
+  }
+  /* 補正点は昇順なので末尾が最後の補正点 */
+  fastFinalCorrectPoint_ = std::max(numCrossLinePoints_ > 0 ? crossLinePoints_[numCrossLinePoints_ - 1] : 0.0f,
+                                    numCurveMarkerPoints_ > 0 ? curveMarkerPoints_[numCurveMarkerPoints_ - 1] : 0.0f);
+  fastCorrectedDistance_ = 0.0f; /* スタート位置は既知 */
+  fastConfidence_ = 0.0f;
+  fastRejectedCount_ = 0;
 }
 /* 最短走行更新 */
 void VelocityMapping::UpdateFastRunning(float deltaDistance,                 /* 制御周期での変化距離 [m] */
@@ -158,25 +215,14 @@ void VelocityMapping::UpdateFastRunning(float deltaDistance,                 /*
 
   /* 位置を補正 */
   if (isCurveMarker) {
-    for (; fastCurveMarkerPoint_ < numCurveMarkerPoints_; fastCurveMarkerPoint_++) {
-      if (std::abs(curveMarkerPoints_[fastCurveMarkerPoint_] - fastAccDistance_) < kCorrectionAllowErrorCurvature) {
-        fastAccDistance_ = curveMarkerPoints_[fastCurveMarkerPoint_];
-        fastCurveMarkerPoint_++;
-        break;
-      }
-    }
+    CorrectFastRunning(curveMarkerPoints_, numCurveMarkerPoints_, fastCurveMarkerPoint_,
+                       kCorrectionAllowErrorCurvature);
   } else if (isCrossLine) {
-    for (; fastCrossLinePoint_ < numCrossLinePoints_; fastCrossLinePoint_++) {
-      if (std::abs(crossLinePoints_[fastCrossLinePoint_] - fastAccDistance_) < kCorrectionAllowErrorCrossLine) {
-        fastAccDistance_ = crossLinePoints_[fastCrossLinePoint_];
-        fastCrossLinePoint_++;
-        break;
-      }
-    }
+    CorrectFastRunning(crossLinePoints_, numCrossLinePoints_, fastCrossLinePoint_, kCorrectionAllowErrorCrossLine);
   }
 
   /* 速度テーブルの索引位置を更新 */
-  if (fastAccDistance_ >= fastVelocityChangeDistance_) {
+  if (fastAccDistance_.Get() >= fastVelocityChangeDistance_.Get()) {
     if (fastRunningPoint_ < numSearchRunningPoints_) {
       fastVelocityChangeDistance_ += deltaDistanceArray_[fastRunningPoint_];
       fastRunningPoint_++;
@@ -184,15 +230,94 @@ void VelocityMapping::UpdateFastRunning(float deltaDistance,                 /*
   }
 }
 /* 速度を取得 */
-void VelocityMapping::GetFastRunningVelocity(float &now, float &next) {
-  now = velocityVec_[std::min(fastRunningPoint_, static_cast<uint16_t>(numSearchRunningPoints_ - 1))];
-  next = velocityVec_[std::min(static_cast<uint16_t>(fastRunningPoint_ + 1),
-                               static_cast<uint16_t>(numSearchRunningPoints_ - 1))];
+void VelocityMapping::GetFastRunningVelocity(float &now, float &next, float lookahead) {
+  /* 先読み位置を含む区間まで索引位置を進める */
+  float target = fastAccDistance_.Get() + lookahead;
+  uint16_t point = fastRunningPoint_;
+  float end = fastVelocityChangeDistance_.Get();
+  while (target >= end && point < numSearchRunningPoints_) {
+    end += deltaDistanceArray_[point];
+    point++;
+  }
+  now = velocityVec_[std::min(point, static_cast<uint16_t>(numSearchRunningPoints_ - 1))];
+  next = velocityVec_[std::min(static_cast<uint16_t>(point + 1), static_cast<uint16_t>(numSearchRunningPoints_ - 1))];
 }
 /* 走行位置を取得 */
-float VelocityMapping::GetFastRunningDistance() { return fastAccDistance_; }
+float VelocityMapping::GetFastRunningDistance() { return fastAccDistance_.Get(); }
 /* 参照している速度テーブルのインデックスを取得 */
 uint16_t VelocityMapping::GetFastRunningPoint() { return fastRunningPoint_; }
+/* 吸引電圧を取得 */
+float VelocityMapping::GetFastRunningSuctionVoltage() {
+  return suctionVec_[std::min(static_cast<uint32_t>(fastRunningPoint_), static_cast<uint32_t>(suctionVec_.size() - 1))];
+}
+/* 現在位置から先読みした曲率を取得 [1/m] */
+float VelocityMapping::GetFastRunningCurvature(float lookahead, float window) {
+  if (fastRunningPoint_ == 0 || numSearchRunningPoints_ == 0) {
+    return 0.0f;
+  }
+  /* 現在の区間 (fastRunningPoint_ - 1) から先読み位置を含む区間まで進める */
+  float target = fastAccDistance_.Get() + lookahead;
+  uint16_t point = fastRunningPoint_ - 1;
+  float end = fastVelocityChangeDistance_.Get();
+  while (target >= end && point + 1 < numSearchRunningPoints_) {
+    point++;
+    end += deltaDistanceArray_[point];
+  }
+  /* 先読み位置から区間長分の角度を距離で割って平均曲率とする */
+  float distance = 0.0f, angle = 0.0f;
+  for (; point < numSearchRunningPoints_ && distance < window; point++) {
+    distance += deltaDistanceArray_[point];
+    angle += deltaAngleArray_[point];
+  }
+  return distance > 0.0f ? angle / distance : 0.0f;
+}
+/* 先読み位置の前後に未通過の補正点があるか */
+bool VelocityMapping::IsFastRunningCorrectionExpected(CorrectType type, float lookahead, float window) {
+  const auto &points = type == CorrectType::kCurveMarker ? curveMarkerPoints_ : crossLinePoints_;
+  uint16_t numPoints = type == CorrectType::kCurveMarker ? numCurveMarkerPoints_ : numCrossLinePoints_;
+  uint16_t point = type == CorrectType::kCurveMarker ? fastCurveMarkerPoint_ : fastCrossLinePoint_;
+  float target = fastAccDistance_.Get() + lookahead;
+  /* 補正点は昇順なので、範囲の手前を飛ばした最初の点だけ見ればよい */
+  while (point < numPoints && points[point] < target - window) {
+    point++;
+  }
+  return point < numPoints && points[point] < target + window;
+}
+/* 地図上のゴール手前に到達したか (ゴールを過ぎても受け付け続ける) */
+/* 地図がずれていてもゴールを見逃さないよう、判断できないときは受け付ける */
+bool VelocityMapping::IsFastRunningGoalExpected(float window, float growth) {
+  float distance = fastAccDistance_.Get();
+  /* 地図を走り切った・最後の補正点を過ぎた (以降は補正で位置を確かめられない) */
+  if (fastRunningPoint_ >= numSearchRunningPoints_ || distance > fastFinalCorrectPoint_) {
+    return true;
+  }
+  /* 最後の補正から進んだ距離に比例して位置の誤差が増えるので、その分手前から受け付ける */
+  window += growth * (distance - fastCorrectedDistance_);
+  return distance >= fastGoalDistance_ - window;
+}
+/* 直前に受け付けた補正の確からしさを取得 */
+float VelocityMapping::GetFastRunningCorrectionConfidence() { return fastConfidence_; }
+/* 予想位置から外れていて捨てた補正の数を取得 */
+uint16_t VelocityMapping::GetFastRunningRejectedCount() { return fastRejectedCount_; }
+
+/* 予想位置の前後にある補正点で位置を補正 */
+bool VelocityMapping::CorrectFastRunning(const std::array<float, kCorrectionMaxPoints> &points, uint16_t numPoints,
+                                         uint16_t &point, float window) {
+  float distance = fastAccDistance_.Get();
+  /* 範囲より後ろに残った点は見落としたものとして飛ばす (先の点は誤検出で飛ばさない) */
+  while (point < numPoints && points[point] <= distance - window) {
+    point++;
+  }
+  if (point >= numPoints || points[point] >= distance + window) {
+    fastRejectedCount_++;
+    return false;
+  }
+  fastConfidence_ = 1.0f - std::abs(points[point] - distance) / window;
+  fastAccDistance_ = points[point];
+  fastCorrectedDistance_ = points[point];
+  point++;
+  return true;
+}
 
 /* 不揮発メモリから読み出し */
 bool VelocityMapping::LoadSearchRunningPoints() {
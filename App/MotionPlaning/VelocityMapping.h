@@ -3,6 +3,7 @@
 
 /* Project */
 #include "Config.h"
+#include "Data/CompensatedSum.h"
 #include "Wrapper/New.h"
 
 /* C++ */
@@ -19,6 +20,14 @@ class VelocityMapping {
     kCrossLine,
   };
 
+  /* 加速計画に使う電源・モーターの状態 */
+  struct DriveLimit {
+    float openCircuitVoltage; /* バッテリー開放電圧 [V] (0なら電圧で制限しない) */
+    float internalResistance; /* バッテリー内部抵抗 [Ω] */
+    float motorResistance;    /* 温度補正したモーター抵抗 [Ω] */
+    float motorCurrentLimit;  /* 温度で低減したモーター許容電流 [A] */
+  };
+
   /* コンストラクタ */
   VelocityMapping();
 
@@ -50,7 +59,8 @@ class VelocityMapping {
                              const std::vector<float> &maxVelocityVec, /* 半径における並進速度[m/s] */
                              float startVelo,                          /* 開始速度 [m/s] */
                              float accel,                              /* 加速度 [m/ss] */
-                             float decel                               /* 減速度 [m/ss] */
+                             float decel,                              /* 減速度 [m/ss] */
+                             const DriveLimit &limit                   /* 電源・モーターの状態 */
   );
   /* 速度テーブルをリセット */
   void ResetVelocityTable();
@@ -58,6 +68,10 @@ class VelocityMapping {
   bool HasVelocityTable();
   /* 速度テーブルを取得 */
   const std::vector<float> &GetVelocityTable();
+  /* 速度テーブルから区間ごとの吸引電圧を計算 */
+  bool CalculateSuctionTable(float minVoltage, /* 直線での吸引電圧 [V] */
+                             float maxVoltage  /* カーブ・加減速での吸引電圧 [V] */
+  );
 
   /* 最短走行リセット */
   void ResetFastRunning();
@@ -66,13 +80,38 @@ class VelocityMapping {
                          bool isCrossLine, bool isCurveMarker /* 補正位置があるか */
   );
   /* 速度を取得 */
-  void GetFastRunningVelocity(float &now, float &next);
+  void GetFastRunningVelocity(float &now, float &next, float lookahead = 0.0f /* 先読み距離 [m] */);
   /* 走行位置を取得 */
   float GetFastRunningDistance();
   /* 参照している速度テーブルのインデックスを取得 */
   uint16_t GetFastRunningPoint();
+  /* 吸引電圧を取得 [V] */
+  float GetFastRunningSuctionVoltage();
+  /* 現在位置から先読みした曲率を取得 [1/m] (反時計回りが正) */
+  float GetFastRunningCurvature(float lookahead, /* 先読み距離 [m] */
+                                float window     /* 平均する区間長 [m] */
+  );
+  /* 先読み位置の前後に未通過の補正点があるか (マーカー・交差の検出を受け付けるか) */
+  bool IsFastRunningCorrectionExpected(CorrectType type, /* 補正点の種類 */
+                                       float lookahead,  /* 先読み距離 [m] */
+                                       float window      /* 前後の許容距離 [m] */
+  );
+  /* 地図上のゴール手前に到達したか (ゴールマーカーを受け付けるか) */
+  bool IsFastRunningGoalExpected(float window, /* ゴール手前の許容距離 [m] */
+                                 float growth  /* 最後の補正からの距離に対して許容距離を広げる割合 */
+  );
+  /* 直前に受け付けた補正の確からしさを取得 (予想位置と一致で1、許容誤差で0) */
+  float GetFastRunningCorrectionConfidence();
+  /* 予想位置から外れていて捨てた補正の数を取得 */
+  uint16_t GetFastRunningRejectedCount();
 
  private:
+  /* 電圧と許容電流で出せる加速度 [m/ss] */
+  static float AchievableAcceleration(float velocity, const DriveLimit &limit);
+  /* 予想位置の前後にある補正点で位置を補正 (範囲外の検出は誤検出として捨てる) */
+  bool CorrectFastRunning(const std::array<float, kCorrectionMaxPoints> &points, uint16_t numPoints, uint16_t &point,
+                          float window);
+
   /* 探索 */
   float searchAccDistance_;                                   /*  記録中の距離 [m] */
   float searchAccYawRate_;                                    /*  記録中の変化角度 [rad] */
@@ -87,15 +126,21 @@ class VelocityMapping {
 
   /* 速度テーブル */
   std::vector<float> velocityVec_; /* 速度テーブル [m/s] */
+  std::vector<float> suctionVec_;  /* 吸引電圧テーブル [V] */
   bool hasVelocityTable_;          /* 速度テーブルがあるか */
 
   /* 最短 */
   uint16_t fastRunningPoint_;        /* 速度テーブル索引インデックス */
-  float fastAccDistance_;            /* 最短総移動距離 [m] */
-  float fastVelocityChangeDistance_; /* 次の速度変化距離 [m] */
+  CompensatedSum<float> fastAccDistance_;            /* 最短総移動距離 [m] */
+  CompensatedSum<float> fastVelocityChangeDistance_; /* 次の速度変化距離 [m] */
 
   uint16_t fastCrossLinePoint_;   /* 交差点の補正位置 */
   uint16_t fastCurveMarkerPoint_; /* マーカーの補正位置 */
+  float fastGoalDistance_;        /* 地図上のゴール位置 [m] */
+  float fastFinalCorrectPoint_;   /* 地図上の最後の補正点 [m] */
+  float fastCorrectedDistance_;   /* 最後に補正した位置 [m] */
+  float fastConfidence_;          /* 直前の補正の確からしさ */
+  uint16_t fastRejectedCount_;    /* 捨てた補正の数 */
 };
 
 }  // namespace MotionPlaning
@@ -26,7 +26,34 @@ static uint16_t GetTimCount(TIM_HandleTypeDef *htim, bool invert) {
 bool Encoder::Initialize() {
   bool r = HAL_TIM_Encoder_Start(encoders[0], TIM_CHANNEL_ALL) == HAL_OK;
   bool l = HAL_TIM_Encoder_Start(encoders[1], TIM_CHANNEL_ALL) == HAL_OK;
-  return r && l;
+  /* A相立ち上がりのキャプチャでエッジの時刻を取得 */
+  bool rCb = HAL_TIM_RegisterCallback(encoders[0], HAL_TIM_IC_CAPTURE_CB_ID, CaptureCallback) == HAL_OK;
+  bool lCb = HAL_TIM_RegisterCallback(encoders[1], HAL_TIM_IC_CAPTURE_CB_ID, CaptureCallback) == HAL_OK;
+  HAL_NVIC_SetPriority(TIM4_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(TIM4_IRQn);
+  HAL_NVIC_SetPriority(TIM3_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(TIM3_IRQn);
+  return r && l && rCb && lCb;
+}
+
+/* 入力キャプチャ割り込みコールバック */
+void Encoder::CaptureCallback(TIM_HandleTypeDef *htim) {
+  uint32_t now = DWT->CYCCNT;
+  int i = htim == encoders[0] ? 0 : 1;
+  auto &capture = Encoder::Instance().capture_[i];
+  /* キャプチャレジスタにはエッジでのカウント値が保持されている */
+  auto ccr = static_cast<uint16_t>(HAL_TIM_ReadCapturedValue(htim, TIM_CHANNEL_1));
+  capture.edge.count = i == 1 ? static_cast<uint16_t>(UINT16_MAX - ccr) : ccr;
+  capture.edge.cycles = now;
+  capture.fresh = true;
+  /* 周期内で最初のエッジだけを使う */
+  __HAL_TIM_DISABLE_IT(htim, TIM_IT_CC1);
+}
+
+/* 次のエッジで1回だけキャプチャ割り込みを発生させる */
+void Encoder::ArmCapture(TIM_HandleTypeDef *htim) {
+  __HAL_TIM_CLEAR_IT(htim, TIM_IT_CC1);
+  __HAL_TIM_ENABLE_IT(htim, TIM_IT_CC1);
 }
 
 /* リセット */
@@ -35,8 +62,13 @@ void Encoder::Reset() {
   for (int i = 0; i < 2; i++) {
     /* 最新値で上書き */
     last_[i] = GetTimCount(encoders[i], i == 1);
+    capture_[i].fresh = false;
+    hasPrevEdge_[i] = false;
+    ArmCapture(encoders[i]);
   }
   diff_.fill(0);
+  diffCount_.fill(0);
+  velocity_.fill(0);
 }
 
 /* 更新 */
@@ -46,7 +78,37 @@ void Encoder::Update() {
     uint16_t curr = GetTimCount(encoders[i], i == 1);
     int32_t delta = CalcWheelDelta(curr, last_[i]);
     diff_[i] = static_cast<float>(delta) * kAnglePerPulse;
+    diffCount_[i] = delta;
     last_[i] = curr;
+    UpdateVelocity(i, curr, DWT->CYCCNT);
+    ArmCapture(encoders[i]);
+  }
+}
+
+/* M/T法で車輪角速度を算出 */
+/* 周期ごとに最初のエッジ同士の間のパルス数(M)と経過時間(T)から求めるので、低速でも量子化誤差が小さい */
+void Encoder::UpdateVelocity(int i, uint16_t curr, uint32_t now) {
+  const float cyclesToSec = 1.0f / static_cast<float>(SystemCoreClock);
+  if (capture_[i].fresh) {
+    Edge edge = capture_[i].edge;
+    capture_[i].fresh = false;
+    if (hasPrevEdge_[i]) {
+      int32_t m = CalcWheelDelta(edge.count, prevEdge_[i].count);
+      float t = static_cast<float>(edge.cycles - prevEdge_[i].cycles) * cyclesToSec;
+      if (t > 0.0f) {
+        velocity_[i] = static_cast<float>(m) * kAnglePerPulse / t;
+      }
+    }
+    prevEdge_[i] = edge;
+    hasPrevEdge_[i] = true;
+  } else if (hasPrevEdge_[i]) {
+    /* エッジが無い間は前回エッジからの経過時間で上限を抑える (停止時に0へ収束) */
+    int32_t m = CalcWheelDelta(curr, prevEdge_[i].count);
+    float t = static_cast<float>(now - prevEdge_[i].cycles) * cyclesToSec;
+    float bound = static_cast<float>(std::abs(m) + 1) * kAnglePerPulse / t;
+    if (std::abs(velocity_[i]) > bound) {
+      velocity_[i] = std::copysign(bound, velocity_[i]);
+    }
   }
 }
 
@@ -62,6 +124,18 @@ Encoder::Diff Encoder::GetDiff() {
   return diff_;
 }
 
+/* 車輪変化カウントを取得 [pulse] */
+Encoder::DiffCount Encoder::GetDiffCount() {
+  std::scoped_lock<Mutex> lock{mtx_};
+  return diffCount_;
+}
+
+/* M/T法で計測した車輪角速度を取得 [rad/s] */
+Encoder::Velocity Encoder::GetVelocity() {
+  std::scoped_lock<Mutex> lock{mtx_};
+  return velocity_;
+}
+
 /* カウント値から車輪変化角度を算出 */
 int32_t Encoder::CalcWheelDelta(uint16_t curr, uint16_t prev) {
   int32_t delta = curr - prev;
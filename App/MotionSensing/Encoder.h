@@ -5,6 +5,9 @@
 #include <array>
 #include <numbers>
 
+/* STM32CubeMX */
+#include <main.h>
+
 /* Project */
 #include "Config.h"
 #include "Data/Singleton.h"
@@ -21,6 +24,8 @@ class Encoder final : public Singleton<Encoder> {
 
   using Count = std::array<uint16_t, 2>;
   using Diff = std::array<float, 2>;
+  using DiffCount = std::array<int32_t, 2>;
+  using Velocity = std::array<float, 2>;
 
   /* 初期化 */
   bool Initialize();
@@ -37,13 +42,41 @@ class Encoder final : public Singleton<Encoder> {
   /* 車輪変化角度を取得 [rad] */
   Diff GetDiff();
 
+  /* 車輪変化カウントを取得 [pulse] */
+  DiffCount GetDiffCount();
+
+  /* M/T法で計測した車輪角速度を取得 [rad/s] */
+  Velocity GetVelocity();
+
  private:
   static constexpr uint16_t kTimMaxValue = UINT16_MAX;      /* カウント値保持レジスタの分解能 */
   static constexpr uint16_t kTimHalfValue = UINT16_MAX / 2; /* カウント値保持レジスタの分解能(半分) */
 
+  /* 入力キャプチャで取得したエッジ */
+  struct Edge {
+    uint16_t count;  /* エッジでのカウント値 */
+    uint32_t cycles; /* エッジの時刻 [cycle] */
+  };
+  struct Capture {
+    Edge edge;            /* 最新のエッジ */
+    volatile bool fresh;  /* 周期内に新しいエッジを取得したか */
+  };
+
   Mutex mtx_;
   Count last_{};
   Diff diff_{};
+  DiffCount diffCount_{};
+  Velocity velocity_{};
+  std::array<Capture, 2> capture_{}; /* 割り込みで更新 */
+  std::array<Edge, 2> prevEdge_{};   /* 前回計測に使ったエッジ */
+  std::array<bool, 2> hasPrevEdge_{};
+
+  /* 入力キャプチャ割り込みコールバック */
+  static void CaptureCallback(TIM_HandleTypeDef *htim);
+  /* 次のエッジで1回だけキャプチャ割り込みを発生させる */
+  static void ArmCapture(TIM_HandleTypeDef *htim);
+  /* M/T法で車輪角速度を算出 */
+  void UpdateVelocity(int i, uint16_t curr, uint32_t now);
 
   /* カウント値から車輪変化角度を算出 */
   static int32_t CalcWheelDelta(uint16_t curr, uint16_t prev);
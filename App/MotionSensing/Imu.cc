@@ -13,6 +13,7 @@
 #include <numbers>
 
 /* Project */
+#include "Config.h"
 #include "MotionSensing/lsm6dsrx_reg.h"
 
 /* グローバル変数定義 */
@@ -25,15 +26,15 @@ namespace MotionSensing {
 
 class Lsm6dsrx : public Singleton<Lsm6dsrx> {
  public:
-  enum Value : uint32_t {
-    kTemp,
-    kGyroX,
-    kGyroY,
-    kGyroZ,
-    kAccelX,
-    kAccelY,
-    kAccelZ,
-    kNumValue,
+  /* 1周期分のFIFOデータを間引いた値 */
+  struct Batch {
+    std::array<int32_t, 3> gyroSum;  /* ジャイロ積算値 [LSB] */
+    std::array<int32_t, 3> accelSum; /* 加速度積算値 [LSB] */
+    uint32_t numGyro;                /* ジャイロサンプル数 */
+    uint32_t numAccel;               /* 加速度サンプル数 */
+    float gyroZIntegral;             /* タイムスタンプで積分したz軸角速度 [LSB*s] */
+    float duration;                  /* 積分した時間 [s] */
+    int16_t temp;                    /* 温度 [LSB] */
   };
 
   /* コンストラクタ */
@@ -42,35 +43,54 @@ class Lsm6dsrx : public Singleton<Lsm6dsrx> {
   /* 初期化 */
   bool Initialize();
 
-  /* 値を更新 */
+  /* FIFOを空にする */
+  void FlushFifo();
+
+  /* FIFOから値を更新 */
   bool Fetch();
 
-  /* データ取得(生値) */
-  int16_t GetRaw(uint32_t value);
+  /* 間引いた値を取得 */
+  const Batch &GetBatch() const { return batch_; }
 
   /* 単位系に変換 */
-  static float ConvertDegC(int32_t tempRaw) { return static_cast<float>(tempRaw) / 256.0f; }
-  static float ConvertRadPerSec(int32_t gyroRaw) {
-    return static_cast<float>(gyroRaw) * kSensitivityGyro * std::numbers::pi_v<float> / 180.0f;
+  static float ConvertDegC(int32_t tempRaw) { return static_cast<float>(tempRaw) / 256.0f + 25.0f; }
+  static float ConvertRadPerSec(float gyroRaw) {
+    return gyroRaw * kSensitivityGyro * std::numbers::pi_v<float> / 180.0f;
+  }
+  static float ConvertRad(float gyroRawSec) {
+    return gyroRawSec * kSensitivityGyro * std::numbers::pi_v<float> / 180.0f;
   }
-  static float ConvertGravity(int32_t accelRaw) { return static_cast<float>(accelRaw) * kSensitivityAccel; }
-  static float ConvertMeterPerSec2(int32_t accelRaw) { return ConvertGravity(accelRaw) * 9.80665f; }
+  static float ConvertGravity(float accelRaw) { return accelRaw * kSensitivityAccel; }
+  static float ConvertMeterPerSec2(float accelRaw) { return ConvertGravity(accelRaw) * 9.80665f; }
 
  private:
   static constexpr float kSensitivityGyro = 140.0f / 1000.0f;  /* 4000 [deg/s]; 0.140   [deg/s/LSB] */
   static constexpr float kSensitivityAccel = 0.244f / 1000.0f; /* 8        [G]; 0.00244 [G/LSB] */
-
-  StaticSemaphore_t txCpltSemphrBuffer_; /* 送信完了セマフォバッファ */
-  SemaphoreHandle_t txCpltSemphr_;       /* 送信完了セマフォ */
-  StaticSemaphore_t rxCpltSemphrBuffer_; /* 受信完了セマフォバッファ */
-  SemaphoreHandle_t rxCpltSemphr_;       /* 受信完了セマフォ */
-  ALIGN_32BYTES(uint8_t txBuffer_[32]);  /* 送信バッファ */
-  ALIGN_32BYTES(uint8_t rxBuffer_[32]);  /* 受信バッファ */
-
-  /* 送信完了コールバック */
-  static void TxCpltCallback(SPI_HandleTypeDef *);
-  /* 受信完了コールバック */
-  static void RxCpltCallback(SPI_HandleTypeDef *);
+  static constexpr float kTimestampResolution = 25.0e-6f;      /* タイムスタンプ分解能 [s/LSB] */
+  static constexpr float kSamplePeriod = 1.0f / 1666.0f;       /* サンプリング周期 [s] */
+
+  /* FIFOは1ワード = TAG(1byte) + データ(6byte) */
+  /* 1666Hzでジャイロ・加速度・タイムスタンプを積むと1msあたり最大6ワード(平均5ワード)なので余裕を持たせる */
+  /* 格納数は読まずに毎周期この長さを読み、空や重複のワードはTAGで捨てる (遅れた分は数周期で読み切れる) */
+  static constexpr uint32_t kFifoWordBytes = 7;
+  static constexpr uint32_t kFifoBurstWords = 8;
+  static constexpr uint32_t kFifoBurstBytes = 1 + kFifoWordBytes * kFifoBurstWords; /* アドレス + データ */
+  static constexpr uint8_t kFifoTagCntInvalid = 0xFF;                                /* TAG_CNTが未取得 */
+
+  StaticSemaphore_t txRxCpltSemphrBuffer_; /* 送受信完了セマフォバッファ */
+  SemaphoreHandle_t txRxCpltSemphr_;       /* 送受信完了セマフォ */
+  ALIGN_32BYTES(uint8_t txBuffer_[64]);    /* 送信バッファ */
+  ALIGN_32BYTES(uint8_t rxBuffer_[64]);    /* 受信バッファ */
+
+  Batch batch_{};                           /* 間引いた値 */
+  uint32_t timestamp_{0};                   /* 最新のタイムスタンプ [LSB] */
+  uint32_t gyroTimestamp_{0};               /* 前回のジャイロサンプルのタイムスタンプ [LSB] */
+  bool hasGyroTimestamp_{false};            /* 前回のジャイロサンプルのタイムスタンプが有効か */
+  uint8_t gyroTagCnt_{kFifoTagCntInvalid};  /* 前回のジャイロサンプルのTAG_CNT */
+  uint8_t accelTagCnt_{kFifoTagCntInvalid}; /* 前回の加速度サンプルのTAG_CNT */
+
+  /* 送受信完了コールバック */
+  static void TxRxCpltCallback(SPI_HandleTypeDef *);
 
   /* チップセレクト */
   static void ChipSelect(bool enable);
@@ -83,6 +103,9 @@ class Lsm6dsrx : public Singleton<Lsm6dsrx> {
 
   /* LSM6DSRXを設定 */
   bool ConfigureLsm6dsrx();
+
+  /* 受信したFIFOのワードを解析 */
+  void ParseFifo();
 };
 
 /* チップセレクト */
@@ -107,17 +130,10 @@ uint8_t Lsm6dsrx::ReadReg(uint8_t addr) {
   return data;
 }
 
-/* 送信完了コールバック */
-void Lsm6dsrx::TxCpltCallback(SPI_HandleTypeDef *) {
+/* 送受信完了コールバック */
+void Lsm6dsrx::TxRxCpltCallback(SPI_HandleTypeDef *) {
   BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-  xSemaphoreGiveFromISR(Lsm6dsrx::Instance().txCpltSemphr_, &xHigherPriorityTaskWoken);
-  portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
-}
-
-/* 受信完了コールバック */
-void Lsm6dsrx::RxCpltCallback(SPI_HandleTypeDef *) {
-  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-  xSemaphoreGiveFromISR(Lsm6dsrx::Instance().rxCpltSemphr_, &xHigherPriorityTaskWoken);
+  xSemaphoreGiveFromISR(Lsm6dsrx::Instance().txRxCpltSemphr_, &xHigherPriorityTaskWoken);
   portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
@@ -163,58 +179,151 @@ bool Lsm6dsrx::ConfigureLsm6dsrx() {
   reg.ctrl2_g.fs_g = LSM6DSRX_4000dps;
   WriteReg(LSM6DSRX_CTRL2_G, reg.byte);
 
-  /* データ取得用の送信データを準備 */
+  /* CTRL10_C 設定 (タイムスタンプ) */
+  reg.byte = 0;
+  reg.ctrl10_c.timestamp_en = 1;
+  WriteReg(LSM6DSRX_CTRL10_C, reg.byte);
+  /* FIFO_CTRL3 設定 (ジャイロ・加速度をODRと同じ周期で積む) */
+  reg.byte = 0;
+  reg.fifo_ctrl3.bdr_xl = LSM6DSRX_XL_BATCHED_AT_1667Hz;
+  reg.fifo_ctrl3.bdr_gy = LSM6DSRX_GY_BATCHED_AT_1667Hz;
+  WriteReg(LSM6DSRX_FIFO_CTRL3, reg.byte);
+  /* FIFO_CTRL4 設定 (ストリームモード、温度・タイムスタンプも積む) */
+  FlushFifo();
+
+  /* FIFO読み出し用の送信データを準備 (アドレスはFIFO_DATA_OUT_Z_Hの次にTAGへ戻る) */
   memset(txBuffer_, 0, sizeof(txBuffer_));
-  txBuffer_[0] = 0x80 | LSM6DSRX_OUT_TEMP_L;
+  txBuffer_[0] = 0x80 | LSM6DSRX_FIFO_DATA_OUT_TAG;
   SCB_CleanDCache_by_Addr(reinterpret_cast<uint32_t *>(txBuffer_), sizeof(txBuffer_));
 
   return true;
 }
 
 /* コンストラクタ */
-Lsm6dsrx::Lsm6dsrx()
-    : txCpltSemphr_(xSemaphoreCreateBinaryStatic(&txCpltSemphrBuffer_)),
-      rxCpltSemphr_(xSemaphoreCreateBinaryStatic(&rxCpltSemphrBuffer_)) {}
+Lsm6dsrx::Lsm6dsrx() : txRxCpltSemphr_(xSemaphoreCreateBinaryStatic(&txRxCpltSemphrBuffer_)) {}
 
 /* 初期設定 */
 bool Lsm6dsrx::Initialize() {
   bool lsm = ConfigureLsm6dsrx();
-  bool txCb = HAL_SPI_RegisterCallback(&hspi2, HAL_SPI_TX_COMPLETE_CB_ID, TxCpltCallback) == HAL_OK;
-  bool rxCb = HAL_SPI_RegisterCallback(&hspi2, HAL_SPI_RX_COMPLETE_CB_ID, RxCpltCallback) == HAL_OK;
-  return lsm && txCb && rxCb;
+  bool txRxCb = HAL_SPI_RegisterCallback(&hspi2, HAL_SPI_TX_RX_COMPLETE_CB_ID, TxRxCpltCallback) == HAL_OK;
+  return lsm && txRxCb;
+}
+
+/* FIFOを空にする */
+void Lsm6dsrx::FlushFifo() {
+  lsm6dsrx_reg_t reg = {};
+  /* バイパスモードにするとFIFOの中身は破棄される */
+  reg.byte = 0;
+  reg.fifo_ctrl4.fifo_mode = LSM6DSRX_BYPASS_MODE;
+  WriteReg(LSM6DSRX_FIFO_CTRL4, reg.byte);
+  reg.byte = 0;
+  reg.fifo_ctrl4.fifo_mode = LSM6DSRX_STREAM_MODE;
+  reg.fifo_ctrl4.odr_t_batch = LSM6DSRX_TEMP_BATCHED_AT_12Hz5;
+  reg.fifo_ctrl4.odr_ts_batch = LSM6DSRX_DEC_1;
+  WriteReg(LSM6DSRX_FIFO_CTRL4, reg.byte);
+
+  batch_ = {};
+  hasGyroTimestamp_ = false;
+  gyroTagCnt_ = kFifoTagCntInvalid;
+  accelTagCnt_ = kFifoTagCntInvalid;
 }
 
-/* データ取得 */
+/* FIFOから値を更新 */
 bool Lsm6dsrx::Fetch() {
+  static_assert(kFifoBurstBytes <= sizeof(rxBuffer_), "rxBuffer_ must hold a full burst");
   bool ret = false;
   ChipSelect(true);
-  /* 読み出すアドレスを送信 (アドレスは自動でインクリメントされる) */
-  if (HAL_SPI_Transmit_DMA(&hspi2, txBuffer_, 1) == HAL_OK) {
-    if (xSemaphoreTake(txCpltSemphr_, pdMS_TO_TICKS(1)) == pdTRUE) {
-      /* 読み出し */
-      if (HAL_SPI_Receive_DMA(&hspi2, rxBuffer_, kNumValue * 2) == HAL_OK) {
-        if (xSemaphoreTake(rxCpltSemphr_, pdMS_TO_TICKS(1)) == pdTRUE) {
-          /* キャッシュを更新 */
-          SCB_CleanInvalidateDCache_by_Addr(reinterpret_cast<uint32_t *>(rxBuffer_), sizeof(rxBuffer_));
-          ret = true;
-        }
-      }
+  /* アドレス送信とFIFOの読み出しを1回の全二重転送で行う (残りは次の周期に読む) */
+  if (HAL_SPI_TransmitReceive_DMA(&hspi2, txBuffer_, rxBuffer_, kFifoBurstBytes) == HAL_OK) {
+    if (xSemaphoreTake(txRxCpltSemphr_, pdMS_TO_TICKS(1)) == pdTRUE) {
+      /* キャッシュを更新 */
+      SCB_CleanInvalidateDCache_by_Addr(reinterpret_cast<uint32_t *>(rxBuffer_), sizeof(rxBuffer_));
+      ret = true;
     }
   }
   ChipSelect(false);
+  if (ret) {
+    ParseFifo();
+  }
   return ret;
 }
 
-/* データ取得(生値) */
-int16_t Lsm6dsrx::GetRaw(uint32_t value) { return reinterpret_cast<int16_t *>(rxBuffer_)[value]; }
+/* 受信したFIFOのワードを解析 */
+void Lsm6dsrx::ParseFifo() {
+  batch_.gyroSum.fill(0);
+  batch_.accelSum.fill(0);
+  batch_.numGyro = 0;
+  batch_.numAccel = 0;
+  batch_.gyroZIntegral = 0.0f;
+  batch_.duration = 0.0f;
+  for (uint32_t word = 0; word < kFifoBurstWords; word++) {
+    const uint8_t *p = &rxBuffer_[1 + word * kFifoWordBytes];
+    std::array<int16_t, 3> data = {
+        static_cast<int16_t>(p[1] | (p[2] << 8)),
+        static_cast<int16_t>(p[3] | (p[4] << 8)),
+        static_cast<int16_t>(p[5] | (p[6] << 8)),
+    };
+    /* TAG = TAG_SENSOR(5bit) + TAG_CNT(2bit) + パリティ(1bit) */
+    /* 空のFIFOを読むとTAGは0か直前のワードの繰り返しになるので、同じTAG_CNTの2回目のサンプルは捨てる */
+    uint8_t tagCnt = (p[0] >> 1) & 0x03;
+    switch (p[0] >> 3) {
+      case LSM6DSRX_TIMESTAMP_TAG:
+        /* 以降のサンプルはこの時刻のもの */
+        timestamp_ = static_cast<uint32_t>(p[1]) | (static_cast<uint32_t>(p[2]) << 8) |
+                     (static_cast<uint32_t>(p[3]) << 16) | (static_cast<uint32_t>(p[4]) << 24);
+        break;
+      case LSM6DSRX_GYRO_NC_TAG: {
+        if (tagCnt == gyroTagCnt_) {
+          break;
+        }
+        gyroTagCnt_ = tagCnt;
+        /* 前回サンプルからの経過時間で積分 (タイムスタンプが得られない場合は公称周期) */
+        float dt = kSamplePeriod;
+        if (hasGyroTimestamp_ && timestamp_ != gyroTimestamp_) {
+          float elapsed = static_cast<float>(timestamp_ - gyroTimestamp_) * kTimestampResolution;
+          if (elapsed < kSamplePeriod * 4.0f) {
+            dt = elapsed;
+          }
+        }
+        gyroTimestamp_ = timestamp_;
+        hasGyroTimestamp_ = true;
+        for (int i = 0; i < 3; i++) {
+          batch_.gyroSum[i] += data[i];
+        }
+        batch_.numGyro++;
+        batch_.gyroZIntegral += static_cast<float>(data[2]) * dt;
+        batch_.duration += dt;
+      } break;
+      case LSM6DSRX_XL_NC_TAG:
+        if (tagCnt == accelTagCnt_) {
+          break;
+        }
+        accelTagCnt_ = tagCnt;
+        for (int i = 0; i < 3; i++) {
+          batch_.accelSum[i] += data[i];
+        }
+        batch_.numAccel++;
+        break;
+      case LSM6DSRX_TEMPERATURE_TAG:
+        batch_.temp = data[0];
+        break;
+      default:
+        /* 空(0)や使用しないタグは破棄 */
+        break;
+    }
+  }
+}
 
 /**
  * MARK: Imu
  */
 /* 初期化 */
 bool Imu::Initialize() {
+  if (!Lsm6dsrx::Instance().Initialize()) {
+    return false;
+  }
   Reset();
-  return Lsm6dsrx::Instance().Initialize();
+  return true;
 }
 
 /* 内部値を更新(1ms周期で呼び出すこと) */
@@ -223,14 +332,27 @@ bool Imu::Update() {
   if (!lsm.Fetch()) {
     return false;
   }
+  auto &batch = lsm.GetBatch();
   {
     std::scoped_lock<Mutex> lock{mtx_};
-    gyro_[0] = lsm.GetRaw(Lsm6dsrx::kGyroX) - offset_[0];
-    gyro_[1] = lsm.GetRaw(Lsm6dsrx::kGyroY) - offset_[1];
-    gyro_[2] = lsm.GetRaw(Lsm6dsrx::kGyroZ) - offset_[2];
-    accel_[0] = lsm.GetRaw(Lsm6dsrx::kAccelX) - offset_[3];
-    accel_[1] = lsm.GetRaw(Lsm6dsrx::kAccelY) - offset_[4];
-    accel_[2] = lsm.GetRaw(Lsm6dsrx::kAccelZ) - offset_[5];
+    /* 周期内のサンプルを平均して間引く */
+    if (batch.numGyro > 0) {
+      auto num = static_cast<float>(batch.numGyro);
+      for (int i = 0; i < 3; i++) {
+        gyro_[i] = static_cast<float>(batch.gyroSum[i]) / num - offset_[i];
+      }
+      yawDelta_ = Lsm6dsrx::ConvertRad(batch.gyroZIntegral - offset_[2] * batch.duration);
+    } else {
+      /* サンプルが無い周期は前回値を保持 */
+      yawDelta_ = Lsm6dsrx::ConvertRadPerSec(gyro_[2]) * kPeriodicNotifyInterval;
+    }
+    if (batch.numAccel > 0) {
+      auto num = static_cast<float>(batch.numAccel);
+      for (int i = 0; i < 3; i++) {
+        accel_[i] = static_cast<float>(batch.accelSum[i]) / num - offset_[i + 3];
+      }
+    }
+    temp_ = batch.temp;
   }
   return true;
 }
@@ -238,8 +360,10 @@ bool Imu::Update() {
 /* リセット */
 void Imu::Reset() {
   std::scoped_lock<Mutex> lock{mtx_};
-  gyro_.fill(0);
-  accel_.fill(0);
+  Lsm6dsrx::Instance().FlushFifo();
+  gyro_.fill(0.0f);
+  accel_.fill(0.0f);
+  yawDelta_ = 0.0f;
 }
 
 /* オフセットを取得 */
@@ -263,6 +387,15 @@ float Imu::GetAccelY() { return Lsm6dsrx::Instance().ConvertMeterPerSec2(accel_[
 /* ヨーレートを取得 */
 float Imu::GetYawRate() { return Lsm6dsrx::Instance().ConvertRadPerSec(gyro_[2]); }
 
+/* 周期内のヨー角変化量を取得 [rad] */
+float Imu::GetYawDelta() {
+  std::scoped_lock<Mutex> lock{mtx_};
+  return yawDelta_;
+}
+
+/* 温度を取得 [degC] */
+float Imu::GetTemperature() { return Lsm6dsrx::Instance().ConvertDegC(temp_); }
+
 /* 加速度センサの生値を取得 */
 Imu::Raw Imu::GetAccelRaw() {
   std::scoped_lock<Mutex> lock{mtx_};
@@ -1,5 +1,5 @@
 #ifndef MOTIONSENSING_IMU_H_
-#define MOTION_SENSING_IMU_H_
+#define MOTIONSENSING_IMU_H_
 
 /* C++ */
 #include <array>
@@ -14,8 +14,8 @@ namespace MotionSensing {
  */
 class Imu final : public Singleton<Imu> {
  public:
-  using Offset = std::array<int16_t, 6>;
-  using Raw = std::array<int16_t, 3>;
+  using Offset = std::array<float, 6>; /* オフセット(ジャイロxyz, 加速度xyz) [LSB] */
+  using Raw = std::array<float, 3>;    /* オフセット補正済みの生値 [LSB] */
 
   /* 初期化 */
   bool Initialize();
@@ -41,6 +41,12 @@ class Imu final : public Singleton<Imu> {
   /* ヨーレートを取得 [rad/s] */
   float GetYawRate();
 
+  /* 周期内のヨー角変化量を取得 [rad] */
+  float GetYawDelta();
+
+  /* 温度を取得 [degC] */
+  float GetTemperature();
+
   /* 加速度センサの生値を取得 */
   Raw GetAccelRaw();
 
@@ -53,6 +59,8 @@ class Imu final : public Singleton<Imu> {
   Offset offset_{};
   Raw gyro_{};
   Raw accel_{};
+  float yawDelta_{0.0f}; /* FIFOのタイムスタンプで積分したヨー角変化量 [rad] */
+  int16_t temp_{0};
 };
 }  // namespace MotionSensing
 #endif  // MOTIONSENSING_IMU_H_
@@ -1,12 +1,18 @@
 #include "MotionSensing/MotionSensing.h"
 
+/* STM32CubeMX */
+#include <main.h>
+
 /* Projects */
 #include "Config.h"
 #include "MotionSensing/Encoder.h"
 #include "MotionSensing/Imu.h"
+#include "NonVolatileData.h"
 #include "Periodic.h"
 
 /* C++ */
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
 
 namespace MotionSensing {
@@ -14,6 +20,11 @@ MotionSensing::MotionSensing() : odometry_() {}
 
 /* 初期化 */
 bool MotionSensing::Initialize() {
+  /* 処理時間計測用のサイクルカウンタを有効化 */
+  CoreDebug->DEMCR = CoreDebug->DEMCR | CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->LAR = 0xC5ACCE55;
+  DWT->CYCCNT = 0;
+  DWT->CTRL = DWT->CTRL | DWT_CTRL_CYCCNTENA_Msk;
   /* エンコーダー初期化 */
   if (!Encoder::Instance().Initialize()) {
     return false;
@@ -32,7 +43,8 @@ bool MotionSensing::Initialize() {
 /* キャリブレーション */
 bool MotionSensing::CalibrateImu(int32_t sampleNum) {
   Imu::Offset offset{};
-  std::array<int32_t, 6> acc{};
+  std::array<float, 6> acc{};
+  float temperature = 0.0f;
   auto &imu = Imu::Instance();
   imu.Reset();
   imu.SetOffset(offset);
@@ -62,19 +74,159 @@ bool MotionSensing::CalibrateImu(int32_t sampleNum) {
       acc[i] += gyro[i];
       acc[i + 3] += accel[i];
     }
+    temperature += imu.GetTemperature();
   }
-  /* TODO:
-   * 補正値をフラッシュに保存しておいてフラッシュから復元するメソッドを用意 */
+  temperature /= static_cast<float>(sampleNum);
   printf(" ----- MotionSensing::CalibrateImu(%ld) ----- \r\n", sampleNum);
+  printf("temperature: %f\r\n", static_cast<double>(temperature));
   for (int32_t n = 0; n < 6; n++) {
-    offset[n] = static_cast<int16_t>(acc[n] / sampleNum);
-    printf("offset[%ld]: %d\r\n", n, offset[n]);
+    offset[n] = acc[n] / static_cast<float>(sampleNum);
+    printf("offset[%ld]: %f\r\n", n, static_cast<double>(offset[n]));
   }
   imu.SetOffset(offset);
 
+  /* 温度別テーブルに登録して保存 */
+  auto index = BiasTableIndex(temperature);
+  biasTable_[index] = offset;
+  biasValid_[index] = 1;
+  return StoreImuBias();
+}
+
+/* 不揮発メモリからIMUバイアステーブルを読み込み */
+bool MotionSensing::LoadImuBias() {
+  if (!NonVolatileData::ReadImuBiasData(biasValid_, biasTable_)) {
+    biasValid_.fill(0);
+    return false;
+  }
+  printf(" ----- NonVolatileData::ReadImuBiasData ----- \r\n");
+  for (uint32_t i = 0; i < kImuBiasTableNumPoints; i++) {
+    /* 未書き込みの領域は無効とする */
+    if (biasValid_[i] != 1 || !std::all_of(biasTable_[i].begin(), biasTable_[i].end(),
+                                           [](float v) { return std::isfinite(v); })) {
+      biasValid_[i] = 0;
+      continue;
+    }
+    printf("%5.1f degC: gyro(%f, %f, %f)\r\n",
+           static_cast<double>(kImuBiasTableMinTemperature + kImuBiasTableTemperatureStep * static_cast<float>(i)),
+           static_cast<double>(biasTable_[i][0]), static_cast<double>(biasTable_[i][1]),
+           static_cast<double>(biasTable_[i][2]));
+  }
   return true;
 }
 
+/* IMUバイアステーブルを不揮発メモリに保存 */
+bool MotionSensing::StoreImuBias() { return NonVolatileData::WriteImuBiasData(biasValid_, biasTable_); }
+
+/* 現在の温度のバイアスをIMUに設定(テーブルに無ければキャリブレーション) */
+bool MotionSensing::PrepareImu() {
+  auto &imu = Imu::Instance();
+  imu.Reset();
+  /* 温度が得られるまで待つ */
+  for (uint32_t n = 0; n < kImuTemperatureWaitTime; n++) {
+    if (!Periodic::WaitPeriodicNotify()) {
+      return false;
+    }
+    if (!imu.Update()) {
+      imu.Reset();
+      return false;
+    }
+  }
+  if (ApplyBiasTable(imu.GetTemperature())) {
+    return true;
+  }
+  return CalibrateImu(kImuNumCalibrationSample);
+}
+
+/* 温度に最も近いテーブルのインデックス */
+uint32_t MotionSensing::BiasTableIndex(float temperature) {
+  auto index = std::lround((temperature - kImuBiasTableMinTemperature) / kImuBiasTableTemperatureStep);
+  return static_cast<uint32_t>(std::clamp(index, 0l, static_cast<long>(kImuBiasTableNumPoints) - 1));
+}
+
+/* 温度を挟む有効なテーブルのインデックスと補間係数を取得 */
+bool MotionSensing::FindBiasTableRange(float temperature, uint32_t &lower, uint32_t &upper, float &ratio) const {
+  float position = (temperature - kImuBiasTableMinTemperature) / kImuBiasTableTemperatureStep;
+  bool hasLower = false, hasUpper = false;
+  for (uint32_t i = 0; i < kImuBiasTableNumPoints; i++) {
+    if (biasValid_[i] != 1) {
+      continue;
+    }
+    if (static_cast<float>(i) <= position) {
+      lower = i, hasLower = true;
+    }
+    if (static_cast<float>(i) >= position && !hasUpper) {
+      upper = i, hasUpper = true;
+    }
+  }
+  if (!hasLower && !hasUpper) {
+    return false;
+  }
+  /* 片側しか無い場合は端の値を使う */
+  if (!hasLower) {
+    lower = upper;
+  } else if (!hasUpper) {
+    upper = lower;
+  }
+  ratio = lower == upper ? 0.0f
+                         : (position - static_cast<float>(lower)) / static_cast<float>(upper - lower);
+  return true;
+}
+
+/* バイアステーブルから温度に応じたオフセットを設定 */
+bool MotionSensing::ApplyBiasTable(float temperature) {
+  uint32_t lower = 0, upper = 0;
+  float ratio = 0.0f;
+  if (!FindBiasTableRange(temperature, lower, upper, ratio)) {
+    return false;
+  }
+  Imu::Offset offset{};
+  for (uint32_t n = 0; n < offset.size(); n++) {
+    offset[n] = biasTable_[lower][n] + (biasTable_[upper][n] - biasTable_[lower][n]) * ratio;
+  }
+  Imu::Instance().SetOffset(offset);
+  return true;
+}
+
+/* 静止中であればジャイロのバイアスを再推定 */
+void MotionSensing::UpdateStationaryBias(int32_t wheelDeltaCountRight, int32_t wheelDeltaCountLeft) {
+  auto &imu = Imu::Instance();
+  /* 車輪が回っておらず、ヨーレートも小さい間を静止とみなす */
+  if (wheelDeltaCountRight != 0 || wheelDeltaCountLeft != 0 ||
+      std::abs(imu.GetYawRate()) > kImuStationaryYawRate) {
+    stationaryCount_ = 0;
+    stationaryGyroSum_.fill(0.0f);
+    return;
+  }
+  auto gyro = imu.GetGyroRaw();
+  for (int i = 0; i < 3; i++) {
+    stationaryGyroSum_[i] += gyro[i];
+  }
+  if (++stationaryCount_ < kImuStationaryTime) {
+    return;
+  }
+  /* 残差の平均をテーブルに反映 (補間に使う両端を同じだけ動かすと補間値も同じだけ動く) */
+  uint32_t lower = 0, upper = 0;
+  float ratio = 0.0f;
+  auto temperature = imu.GetTemperature();
+  if (!FindBiasTableRange(temperature, lower, upper, ratio)) {
+    Imu::Offset offset{};
+    imu.GetOffset(offset);
+    lower = upper = BiasTableIndex(temperature);
+    biasTable_[lower] = offset;
+    biasValid_[lower] = 1;
+  }
+  for (int i = 0; i < 3; i++) {
+    float residual = kImuBiasUpdateGain * stationaryGyroSum_[i] / static_cast<float>(stationaryCount_);
+    biasTable_[lower][i] += residual;
+    if (upper != lower) {
+      biasTable_[upper][i] += residual;
+    }
+  }
+  ApplyBiasTable(temperature);
+  stationaryCount_ = 0;
+  stationaryGyroSum_.fill(0.0f);
+}
+
 /* タスク */
 void MotionSensing::TaskEntry() {
   uint32_t notify = 0;
@@ -84,6 +236,8 @@ void MotionSensing::TaskEntry() {
     Imu::Instance().Reset();
     Encoder::Instance().Reset();
     odometry_.Reset();
+    stationaryCount_ = 0;
+    stationaryGyroSum_.fill(0.0f);
     while (true) {
       /* TODO: タイムアウト */
       if (!TaskNotifyWait(notify)) {
@@ -97,8 +251,13 @@ void MotionSensing::TaskEntry() {
         auto &encoder = Encoder::Instance();
         imu.Update();
         encoder.Update();
-        auto angleDiff = encoder.GetDiff();
-        odometry_.Update(angleDiff[0], angleDiff[1], imu.GetAccelY(), imu.GetYawRate());
+        auto countDiff = encoder.GetDiffCount();
+        auto wheelVelocity = encoder.GetVelocity();
+        odometry_.Update(countDiff[0], countDiff[1], wheelVelocity[0], wheelVelocity[1], imu.GetAccelY(),
+                         imu.GetYawRate(), imu.GetYawDelta());
+        UpdateStationaryBias(countDiff[0], countDiff[1]);
+        /* 温度変化に追従 */
+        ApplyBiasTable(imu.GetTemperature());
       }
     }
   }
@@ -2,9 +2,14 @@
 #define MOTIONSENSING_MOTIONSENSING_H_
 
 /* Projects */
+#include "Config.h"
+#include "MotionSensing/Imu.h"
 #include "Odometry.h"
 #include "Wrapper/Task.h"
 
+/* C++ */
+#include <array>
+
 namespace MotionSensing {
 class MotionSensing final : public Task<MotionSensing> {
  public:
@@ -17,6 +22,15 @@ class MotionSensing final : public Task<MotionSensing> {
   /* キャリブレーション */
   bool CalibrateImu(int32_t sampleNum);
 
+  /* 不揮発メモリからIMUバイアステーブルを読み込み */
+  bool LoadImuBias();
+
+  /* IMUバイアステーブルを不揮発メモリに保存 */
+  bool StoreImuBias();
+
+  /* 現在の温度のバイアスをIMUに設定(テーブルに無ければキャリブレーション) */
+  bool PrepareImu();
+
   /* オドメトリを取得 */
   OdometryImpl &Odometry() { return odometry_; }
 
@@ -26,6 +40,23 @@ class MotionSensing final : public Task<MotionSensing> {
 
  private:
   OdometryImpl odometry_;
+
+  /* 温度別IMUバイアステーブル */
+  std::array<uint8_t, kImuBiasTableNumPoints> biasValid_{};
+  std::array<Imu::Offset, kImuBiasTableNumPoints> biasTable_{};
+
+  /* 静止時のバイアス再推定 */
+  uint32_t stationaryCount_{0};
+  std::array<float, 3> stationaryGyroSum_{};
+
+  /* 温度に最も近いテーブルのインデックス */
+  static uint32_t BiasTableIndex(float temperature);
+  /* 温度を挟む有効なテーブルのインデックスと補間係数を取得 */
+  bool FindBiasTableRange(float temperature, uint32_t &lower, uint32_t &upper, float &ratio) const;
+  /* バイアステーブルから温度に応じたオフセットを設定 */
+  bool ApplyBiasTable(float temperature);
+  /* 静止中であればジャイロのバイアスを再推定 */
+  void UpdateStationaryBias(int32_t wheelDeltaCountRight, int32_t wheelDeltaCountLeft);
 };
 }  // namespace MotionSensing
 #endif  // MOTIONSENSING_MOTIONSENSING_H_
@@ -1,44 +1,128 @@
 #include "MotionSensing/Odometry.h"
 
 /* C++ */
+#include <algorithm>
 #include <cmath>
 #include <mutex>
 
+/* STM32CubeMX */
+#include <main.h>
+
 /* Project */
 #include "Config.h"
+#include "MotionSensing/Encoder.h"
 
 namespace MotionSensing {
+namespace {
+/* 左右カウントの和1あたりの並進距離 [m] */
+constexpr double kDistancePerCount = static_cast<double>(Encoder::kAnglePerPulse * kWheelRadius) / 2.0;
+}  // namespace
+
 /* コンストラクタ */
-OdometryImpl::OdometryImpl() { Reset(); }
+OdometryImpl::OdometryImpl() : transCount_(kDistancePerCount) { Reset(); }
 
 /* リセット */
 void OdometryImpl::Reset() {
   std::scoped_lock<Mutex> lock(mtx_);
   deltaDispTrans_ = 0.0f;
   acc_ = {}, vel_ = {}, dis_ = {}, pose_ = {};
-  transVeloAvg_.Reset();
+  transCount_.Reset();
+  rotSum_.Reset();
+  xSum_.Reset(), ySum_.Reset();
+  transFilter_.Reset({0.0f, 0.0f}, {{{0.0f, 0.0f}, {0.0f, 1.0f}}});
+  rotFilter_.Reset({0.0f, 0.0f}, {{{0.0f, 0.0f}, {0.0f, 0.01f}}});
+  estimatorCycles_ = 0;
+  prevEncoderVelocity_ = 0.0f;
+  wheelAccel_ = 0.0f, bodyAccel_ = 0.0f;
+  slipTime_ = 0, gripTime_ = 0;
+  slipping_ = false;
 }
 
 /* オドメトリ・デッドレコニングを更新 */
-void OdometryImpl::Update(float wheelDeltaAngleRight, /* エンコーダーから取得した車輪変化角度(右) [rad] */
-                      float wheelDeltaAngleLeft, /* エンコーダーから取得した車輪変化角度(左) [rad] */
-                      float accelY,              /* IMUから取得したy軸加速度 [m/ss] */
-                      float yawRate              /* IMUから取得したz軸角速度 [rad/s] */
+void OdometryImpl::Update(int32_t wheelDeltaCountRight, /* エンコーダーから取得した車輪変化カウント(右) [pulse] */
+                          int32_t wheelDeltaCountLeft,  /* エンコーダーから取得した車輪変化カウント(左) [pulse] */
+                          float wheelVelocityRight,     /* エンコーダーからM/T法で取得した車輪角速度(右) [rad/s] */
+                          float wheelVelocityLeft,      /* エンコーダーからM/T法で取得した車輪角速度(左) [rad/s] */
+                          float accelY,                 /* IMUから取得したy軸加速度 [m/ss] */
+                          float yawRate,                /* IMUから取得したz軸角速度 [rad/s] */
+                          float yawDelta                /* IMUから取得した周期内のヨー角変化量 [rad] */
 ) {
+  constexpr float dt = kPeriodicNotifyInterval;
   std::scoped_lock<Mutex> lock(mtx_);
-  deltaDispTrans_ = (wheelDeltaAngleRight + wheelDeltaAngleLeft) * kWheelRadius / 2.0f;
-  transVeloAvg_.Update(deltaDispTrans_ / kPeriodicNotifyInterval);
+  uint32_t startCycles = DWT->CYCCNT;
+  float encoderVelocity = (wheelVelocityRight + wheelVelocityLeft) * kWheelRadius / 2.0f;
+  float encoderYawRate = (wheelVelocityRight - wheelVelocityLeft) * kWheelRadius / kTreadWidth;
+
+  /* スリップ検出: 車輪加速度と加速度センサーの差が続いたらスリップ */
+  {
+    constexpr float alpha = dt / (kSlipFilterTimeConstant + dt);
+    float wheelAccel = (encoderVelocity - prevEncoderVelocity_) / dt;
+    float bodyAccel = accelY - transFilter_.Get()[1];
+    prevEncoderVelocity_ = encoderVelocity;
+    wheelAccel_ += alpha * (wheelAccel - wheelAccel_);
+    bodyAccel_ += alpha * (bodyAccel - bodyAccel_);
+    if (std::abs(wheelAccel_ - bodyAccel_) > kSlipAccelerationThreshold) {
+      gripTime_ = 0;
+      if (++slipTime_ >= kSlipDetectTime) {
+        slipping_ = true;
+      }
+    } else {
+      slipTime_ = 0;
+      if (++gripTime_ >= kSlipReleaseTime) {
+        slipping_ = false;
+      }
+    }
+  }
 
-  acc_.trans = accelY;
-  acc_.rot = (yawRate - vel_.rot) / kPeriodicNotifyInterval;
-  vel_.trans = transVeloAvg_.Get();
-  vel_.rot = yawRate;
-  dis_.trans += deltaDispTrans_;
-  dis_.rot += yawRate * kPeriodicNotifyInterval;
+  /* 並進: 加速度で予測し、エンコーダー速度で補正 (スリップ中はエンコーダーを信用しない) */
+  {
+    constexpr KalmanFilter2<float>::Matrix f = {{{1.0f, -dt}, {0.0f, 1.0f}}};
+    constexpr KalmanFilter2<float>::Matrix q = {
+        {{kEstimatorAccelNoise * kEstimatorAccelNoise * dt * dt, 0.0f},
+         {0.0f, kEstimatorAccelBiasDrift * kEstimatorAccelBiasDrift * dt}}};
+    transFilter_.Predict(f, {accelY * dt, 0.0f}, q);
+    constexpr float r = kEstimatorEncoderVelocityNoise * kEstimatorEncoderVelocityNoise;
+    transFilter_.Correct({1.0f, 0.0f}, encoderVelocity,
+                         slipping_ ? r * kSlipEncoderNoiseScale * kSlipEncoderNoiseScale : r);
+  }
+  /* 旋回: ジャイロとエンコーダー角速度で補正 (差分からジャイロの残留バイアスを推定) */
+  {
+    constexpr KalmanFilter2<float>::Matrix f = {{{1.0f, 0.0f}, {0.0f, 1.0f}}};
+    constexpr KalmanFilter2<float>::Matrix q = {
+        {{kEstimatorYawAccelNoise * kEstimatorYawAccelNoise * dt * dt, 0.0f},
+         {0.0f, kEstimatorGyroBiasDrift * kEstimatorGyroBiasDrift * dt}}};
+    rotFilter_.Predict(f, {0.0f, 0.0f}, q);
+    rotFilter_.Correct({1.0f, 1.0f}, yawRate, kEstimatorGyroNoise * kEstimatorGyroNoise);
+    rotFilter_.Correct({1.0f, 0.0f}, encoderYawRate,
+                       kEstimatorEncoderYawRateNoise * kEstimatorEncoderYawRateNoise);
+  }
+  auto trans = transFilter_.Get();
+  auto rot = rotFilter_.Get();
+
+  acc_.trans = accelY - trans[1];
+  acc_.rot = (rot[0] - vel_.rot) / dt;
+  vel_.trans = trans[0];
+  vel_.rot = rot[0];
+  /* 周期変位と走行距離は同じカウントから求め、記憶と補正の距離をずらさない */
+  int32_t deltaCount = wheelDeltaCountRight + wheelDeltaCountLeft;
+  if (slipping_) {
+    /* スリップ中は車輪の空転分を含まない推定速度からカウントを求める */
+    deltaCount = transCount_.AddDistance(vel_.trans * dt);
+  } else {
+    transCount_.Add(deltaCount);
+  }
+  deltaDispTrans_ = transCount_.ToDistance(deltaCount);
+  dis_.trans = transCount_.Get();
+  /* 角度はタイムスタンプで積分したジャイロから推定バイアス分を除く */
+  rotSum_ += yawDelta - rot[1] * dt;
+  dis_.rot = rotSum_.Get();
 
   pose_.theta = dis_.rot;
-  pose_.x += (vel_.trans * kPeriodicNotifyInterval) * cosf(pose_.theta);
-  pose_.y += (vel_.trans * kPeriodicNotifyInterval) * sinf(pose_.theta);
+  xSum_ += (vel_.trans * kPeriodicNotifyInterval) * cosf(pose_.theta);
+  ySum_ += (vel_.trans * kPeriodicNotifyInterval) * sinf(pose_.theta);
+  pose_.x = xSum_.Get();
+  pose_.y = ySum_.Get();
+  estimatorCycles_ = std::max(estimatorCycles_, DWT->CYCCNT - startCycles);
 }
 
 /* 周期での変位距離を取得 */
@@ -67,4 +151,15 @@ Pose OdometryImpl::GetPose() const {
   std::scoped_lock<Mutex> lock(mtx_);
   return pose_;
 }
+/* 状態推定1回あたりの最大処理サイクル数を取得 */
+uint32_t OdometryImpl::GetEstimatorCycles() const {
+  std::scoped_lock<Mutex> lock(mtx_);
+  return estimatorCycles_;
+}
+
+/* 車輪がスリップしているか */
+bool OdometryImpl::IsSlipping() const {
+  std::scoped_lock<Mutex> lock(mtx_);
+  return slipping_;
+}
 }  // namespace MotionSensing
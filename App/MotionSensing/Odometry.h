@@ -3,7 +3,9 @@
 
 /* Project */
 #include "Config.h"
-#include "Data/MovingAverage.h"
+#include "Data/CompensatedSum.h"
+#include "Data/CountDistance.h"
+#include "Data/KalmanFilter.h"
 #include "Wrapper/Mutex.h"
 
 namespace MotionSensing {
@@ -23,10 +25,13 @@ class OdometryImpl {
   void Reset();
 
   /* オドメトリ・デッドレコニングを更新 */
-  void Update(float wheelAngleRight, /* エンコーダーから取得した車輪角度(右) [rad] */
-              float wheelAngleLeft,  /* エンコーダーから取得した車輪角度(左) [rad] */
-              float accelY,          /* IMUから取得したy軸加速度 [m/ss] */
-              float yawRate          /* IMUから取得したz軸角速度 [rad/s] */
+  void Update(int32_t wheelDeltaCountRight, /* エンコーダーから取得した車輪変化カウント(右) [pulse] */
+              int32_t wheelDeltaCountLeft,  /* エンコーダーから取得した車輪変化カウント(左) [pulse] */
+              float wheelVelocityRight,     /* エンコーダーからM/T法で取得した車輪角速度(右) [rad/s] */
+              float wheelVelocityLeft,      /* エンコーダーからM/T法で取得した車輪角速度(左) [rad/s] */
+              float accelY,                 /* IMUから取得したy軸加速度 [m/ss] */
+              float yawRate,                /* IMUから取得したz軸角速度 [rad/s] */
+              float yawDelta                /* IMUから取得した周期内のヨー角変化量 [rad] */
   );
 
   /* 周期での変位距離を取得 */
@@ -40,12 +45,31 @@ class OdometryImpl {
   Polar GetDisplacement() const;
   /* 姿勢を取得 */
   Pose GetPose() const;
+  /* 状態推定1回あたりの最大処理サイクル数を取得 */
+  uint32_t GetEstimatorCycles() const;
+  /* 車輪がスリップしているか */
+  bool IsSlipping() const;
 
  private:
   mutable Mutex mtx_;
   float deltaDispTrans_;
 
-  MovingAverage<float, float, kEncoderNumMovingAverage> transVeloAvg_;
+  KalmanFilter2<float> transFilter_; /* 並進 [速度 m/s, 加速度センサーバイアス m/ss] */
+  KalmanFilter2<float> rotFilter_;   /* 旋回 [角速度 rad/s, ジャイロバイアス rad/s] */
+  uint32_t estimatorCycles_{0};      /* 状態推定の最大処理サイクル数 */
+
+  /* 長距離で丸め誤差が蓄積しないよう、距離はカウントの整数和で、角度・座標は補償付きで積算する */
+  CountDistance transCount_;          /* 左右車輪カウントの和 [pulse] */
+  CompensatedSum<float> rotSum_;      /* 回転角度 [rad] */
+  CompensatedSum<float> xSum_, ySum_; /* 座標 [m] */
+
+  /* スリップ検出 (車輪と車体の加速度を比較) */
+  float prevEncoderVelocity_{0.0f}; /* 前回のエンコーダー速度 [m/s] */
+  float wheelAccel_{0.0f};          /* 車輪加速度 (フィルタ後) [m/ss] */
+  float bodyAccel_{0.0f};           /* 車体加速度 (フィルタ後) [m/ss] */
+  uint32_t slipTime_{0};            /* スリップ判定の連続時間 [ms] */
+  uint32_t gripTime_{0};            /* グリップ判定の連続時間 [ms] */
+  bool slipping_{false};            /* スリップ中か */
 
   Polar acc_{}; /* 加速度 [m/ss] */
   Polar vel_{}; /* 速度 [m/s]*/
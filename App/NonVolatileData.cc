@@ -135,6 +135,82 @@ bool ReadPositionCorrectionData(std::array<float, kCorrectionMaxPoints>& crossLi
 
   return true;
 }
+/* IMUバイアスを書き込み */
+bool WriteImuBiasData(const std::array<uint8_t, kImuBiasTableNumPoints>& valid,
+                      const std::array<std::array<float, 6>, kImuBiasTableNumPoints>& offset) {
+  auto& fram = Fram::Instance();
+
+  return fram.Write(kAddressImuBiasDataValid, &valid, sizeof(valid)) &&
+         fram.Write(kAddressImuBiasDataOffset, &offset, sizeof(offset));
+}
+/* IMUバイアスを読み出し */
+bool ReadImuBiasData(std::array<uint8_t, kImuBiasTableNumPoints>& valid,
+                     std::array<std::array<float, 6>, kImuBiasTableNumPoints>& offset) {
+  auto& fram = Fram::Instance();
+
+  return fram.Read(kAddressImuBiasDataValid, &valid, sizeof(valid)) &&
+         fram.Read(kAddressImuBiasDataOffset, &offset, sizeof(offset));
+}
+/* 摩擦補償を書き込み */
+bool WriteFrictionData(const std::array<float, 2>& breakaway, const std::array<float, 2>& coulomb,
+                       const std::array<float, 2>& viscous) {
+  auto& fram = Fram::Instance();
+  uint8_t valid = 1;
+
+  return fram.Write(kAddressFrictionDataBreakaway, &breakaway, sizeof(breakaway)) &&
+         fram.Write(kAddressFrictionDataCoulomb, &coulomb, sizeof(coulomb)) &&
+         fram.Write(kAddressFrictionDataViscous, &viscous, sizeof(viscous)) &&
+         fram.Write(kAddressFrictionDataValid, &valid, sizeof(valid));
+}
+/* 摩擦補償を読み出し */
+bool ReadFrictionData(std::array<float, 2>& breakaway, std::array<float, 2>& coulomb, std::array<float, 2>& viscous) {
+  auto& fram = Fram::Instance();
+  uint8_t valid = 0;
+
+  return fram.Read(kAddressFrictionDataValid, &valid, sizeof(valid)) && valid == 1 &&
+         fram.Read(kAddressFrictionDataBreakaway, &breakaway, sizeof(breakaway)) &&
+         fram.Read(kAddressFrictionDataCoulomb, &coulomb, sizeof(coulomb)) &&
+         fram.Read(kAddressFrictionDataViscous, &viscous, sizeof(viscous));
+}
+/* フォールト履歴を追記 */
+bool AppendFaultHistoryData(uint32_t tick, uint32_t code) {
+  auto& fram = Fram::Instance();
+  uint32_t count = 0;
+  if (!fram.Read(kAddressFaultHistoryDataCount, &count, sizeof(count))) {
+    return false;
+  }
+  uint32_t index = count % kFaultHistoryNumRecords;
+  count++;
+  /* 記録を書いてから総数を更新する (途中で電源が落ちても古い記録が壊れるだけ) */
+  return fram.Write(kAddressFaultHistoryDataTick + index * sizeof(uint32_t), &tick, sizeof(tick)) &&
+         fram.Write(kAddressFaultHistoryDataCode + index * sizeof(uint32_t), &code, sizeof(code)) &&
+         fram.Write(kAddressFaultHistoryDataCount, &count, sizeof(count));
+}
+/* フォールト履歴を読み出し */
+bool ReadFaultHistoryData(std::array<uint32_t, kFaultHistoryNumRecords>& tick,
+                          std::array<uint32_t, kFaultHistoryNumRecords>& code, uint32_t& count) {
+  auto& fram = Fram::Instance();
+
+  return fram.Read(kAddressFaultHistoryDataCount, &count, sizeof(count)) &&
+         fram.Read(kAddressFaultHistoryDataTick, &tick, sizeof(tick)) &&
+         fram.Read(kAddressFaultHistoryDataCode, &code, sizeof(code));
+}
+/* ラインセンサーエラーから横ずれへの換算を書き込み */
+bool WriteLineOffsetData(float errorToOffset) {
+  auto& fram = Fram::Instance();
+  uint8_t valid = 1;
+
+  return fram.Write(kAddressLineOffsetDataErrorToOffset, &errorToOffset, sizeof(errorToOffset)) &&
+         fram.Write(kAddressLineOffsetDataValid, &valid, sizeof(valid));
+}
+/* ラインセンサーエラーから横ずれへの換算を読み出し */
+bool ReadLineOffsetData(float& errorToOffset) {
+  auto& fram = Fram::Instance();
+  uint8_t valid = 0;
+
+  return fram.Read(kAddressLineOffsetDataValid, &valid, sizeof(valid)) && valid == 1 &&
+         fram.Read(kAddressLineOffsetDataErrorToOffset, &errorToOffset, sizeof(errorToOffset));
+}
 /* ログ数を書き込み */
 bool WriteLogDataNumBytes(uint32_t bytes) {
   auto& fram = Fram::Instance();
@@ -35,7 +35,30 @@ struct NonVolatileDataAddress {
     uint16_t numCurveMarkerPoints;                       /*  */
     std::array<float, kCorrectionMaxPoints> curveMarker; /* [m] */
   } positionCorrection;
-  /* 4. ログ領域 */
+  /* 4. IMUバイアス(温度別) */
+  struct ImuBiasData {
+    std::array<uint8_t, kImuBiasTableNumPoints> valid;               /* 1: 有効 */
+    std::array<std::array<float, 6>, kImuBiasTableNumPoints> offset; /* [LSB] */
+  } imuBias;
+  /* 5. 摩擦補償 */
+  struct FrictionData {
+    uint8_t valid;                  /* 1: 有効 */
+    std::array<float, 2> breakaway; /* [V] */
+    std::array<float, 2> coulomb;   /* [V] */
+    std::array<float, 2> viscous;   /* [V/(m/s)] */
+  } friction;
+  /* 6. フォールト履歴 (リングバッファ) */
+  struct FaultHistoryData {
+    uint32_t count;                                     /* 追記した総数 */
+    std::array<uint32_t, kFaultHistoryNumRecords> tick; /* [ms] */
+    std::array<uint32_t, kFaultHistoryNumRecords> code; /* FaultCodeの論理和 */
+  } faultHistory;
+  /* 7. ラインセンサーエラーから横ずれへの換算 */
+  struct LineOffsetData {
+    uint8_t valid;       /* 1: 有効 */
+    float errorToOffset; /* [m] */
+  } lineOffset;
+  /* 8. ログ領域 */
   struct LogData {
     uint32_t bytes;
     uint8_t dummyLogData;
@@ -70,7 +93,23 @@ static constexpr uint32_t kAddressPositionCorrectionDataNumCurveMarkerPoints =
     offsetof(NonVolatileDataAddress, positionCorrection.numCurveMarkerPoints);
 static constexpr uint32_t kAddressPositionCorrectionDataCurveMarker =
     offsetof(NonVolatileDataAddress, positionCorrection.curveMarker);
-/* 4. ログ領域 */
+/* 4. IMUバイアス(温度別) */
+static constexpr uint32_t kAddressImuBiasDataValid = offsetof(NonVolatileDataAddress, imuBias.valid);
+static constexpr uint32_t kAddressImuBiasDataOffset = offsetof(NonVolatileDataAddress, imuBias.offset);
+/* 5. 摩擦補償 */
+static constexpr uint32_t kAddressFrictionDataValid = offsetof(NonVolatileDataAddress, friction.valid);
+static constexpr uint32_t kAddressFrictionDataBreakaway = offsetof(NonVolatileDataAddress, friction.breakaway);
+static constexpr uint32_t kAddressFrictionDataCoulomb = offsetof(NonVolatileDataAddress, friction.coulomb);
+static constexpr uint32_t kAddressFrictionDataViscous = offsetof(NonVolatileDataAddress, friction.viscous);
+/* 6. フォールト履歴 */
+static constexpr uint32_t kAddressFaultHistoryDataCount = offsetof(NonVolatileDataAddress, faultHistory.count);
+static constexpr uint32_t kAddressFaultHistoryDataTick = offsetof(NonVolatileDataAddress, faultHistory.tick);
+static constexpr uint32_t kAddressFaultHistoryDataCode = offsetof(NonVolatileDataAddress, faultHistory.code);
+/* 7. ラインセンサーエラーから横ずれへの換算 */
+static constexpr uint32_t kAddressLineOffsetDataValid = offsetof(NonVolatileDataAddress, lineOffset.valid);
+static constexpr uint32_t kAddressLineOffsetDataErrorToOffset =
+    offsetof(NonVolatileDataAddress, lineOffset.errorToOffset);
+/* 8. ログ領域 */
 static constexpr uint32_t kAddressLogDataBytes = offsetof(NonVolatileDataAddress, logData.bytes);
 static constexpr uint32_t kAddressLogData = offsetof(NonVolatileDataAddress, logData.dummyLogData);
 static constexpr uint32_t kCapacityLogData = Fram::kMaxAddress - kAddressLogData;
@@ -98,6 +137,30 @@ bool ReadPositionCorrectionData(std::array<float, kCorrectionMaxPoints>& crossLi
                                 std::array<float, kCorrectionMaxPoints>& curveMarkerArray,
                                 uint16_t& numCurveMarkerPoints);
 
+/* IMUバイアスを書き込み */
+bool WriteImuBiasData(const std::array<uint8_t, kImuBiasTableNumPoints>& valid,
+                      const std::array<std::array<float, 6>, kImuBiasTableNumPoints>& offset);
+/* IMUバイアスを読み出し */
+bool ReadImuBiasData(std::array<uint8_t, kImuBiasTableNumPoints>& valid,
+                     std::array<std::array<float, 6>, kImuBiasTableNumPoints>& offset);
+
+/* 摩擦補償を書き込み */
+bool WriteFrictionData(const std::array<float, 2>& breakaway, const std::array<float, 2>& coulomb,
+                       const std::array<float, 2>& viscous);
+/* 摩擦補償を読み出し (未書き込みなら false) */
+bool ReadFrictionData(std::array<float, 2>& breakaway, std::array<float, 2>& coulomb, std::array<float, 2>& viscous);
+
+/* フォールト履歴を追記 (古いものから上書き) */
+bool AppendFaultHistoryData(uint32_t tick, uint32_t code);
+/* フォールト履歴を読み出し (count は追記した総数、最新は (count - 1) % kFaultHistoryNumRecords) */
+bool ReadFaultHistoryData(std::array<uint32_t, kFaultHistoryNumRecords>& tick,
+                          std::array<uint32_t, kFaultHistoryNumRecords>& code, uint32_t& count);
+
+/* ラインセンサーエラーから横ずれへの換算を書き込み */
+bool WriteLineOffsetData(float errorToOffset);
+/* ラインセンサーエラーから横ずれへの換算を読み出し (未書き込みなら false) */
+bool ReadLineOffsetData(float& errorToOffset);
+
 /* ログ数を書き込み */
 bool WriteLogDataNumBytes(uint32_t bytes);
 /* ログ数を読み出し */
@@ -0,0 +1,39 @@
+#include "PowerMonitoring/MotorThermal.h"
+
+/* C++ */
+#include <algorithm>
+#include <cmath>
+
+namespace PowerMonitoring {
+/* リセット */
+void MotorThermal::Reset() {
+  temperature_ = {kMotorAmbientTemperature, kMotorAmbientTemperature};
+  resistance_ = {kMotorResistance, kMotorResistance};
+  currentLimit_ = {kMotorCurrentLimit, kMotorCurrentLimit};
+}
+
+/* 更新 */
+void MotorThermal::Update(const Amount &current) {
+  static constexpr float dt = kPeriodicNotifyInterval;
+  static constexpr float kCapacity = kMotorThermalTimeConstant / kMotorThermalResistance; /* 熱容量 [J/K] */
+  for (int i = 0; i < 2; i++) {
+    /* 温度 */
+    float heat = current[i] * current[i] * resistance_[i];
+    float cooling = (temperature_[i] - kMotorAmbientTemperature) / kMotorThermalResistance;
+    temperature_[i] += (heat - cooling) / kCapacity * dt;
+    /* 銅線の抵抗は温度に比例して増える */
+    float rise = temperature_[i] - kMotorAmbientTemperature;
+    resistance_[i] = kMotorResistance * (1.0f + kMotorResistanceTemperatureCoefficient * rise);
+    /* 予測時間で上限温度に届く発熱量から許容電流を求める */
+    float allowance = (kMotorTemperatureLimit - temperature_[i]) * kCapacity / kMotorDeratingHorizon + cooling;
+    currentLimit_[i] = std::min(std::sqrt(std::max(allowance, 0.0f) / resistance_[i]), kMotorCurrentLimit);
+  }
+}
+
+/* 推定温度を取得 */
+const MotorThermal::Amount &MotorThermal::GetTemperature() const { return temperature_; }
+/* 温度補正したモーター抵抗を取得 */
+const MotorThermal::Amount &MotorThermal::GetResistance() const { return resistance_; }
+/* 許容電流を取得 */
+const MotorThermal::Amount &MotorThermal::GetCurrentLimit() const { return currentLimit_; }
+}  // namespace PowerMonitoring
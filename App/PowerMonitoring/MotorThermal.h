@@ -0,0 +1,37 @@
+#ifndef POWERMONITORING_MOTORTHERMAL_H_
+#define POWERMONITORING_MOTORTHERMAL_H_
+
+/* Project */
+#include "Config.h"
+
+/* C++ */
+#include <array>
+
+namespace PowerMonitoring {
+/* モーターの温度モデル (巻線と筐体を1つの熱容量とみなす一次遅れ) */
+/* 発熱 I^2 R(T) と周囲への放熱 (T - Ta) / Rth から巻線温度を推定し、抵抗と許容電流を求める */
+class MotorThermal {
+ public:
+  using Amount = std::array<float, 2>;
+
+  /* リセット (周囲温度から始める) */
+  void Reset();
+
+  /* 更新 */
+  void Update(const Amount &current /* モーター電流 [A] */);
+
+  /* 推定温度を取得 [℃] */
+  const Amount &GetTemperature() const;
+  /* 温度補正したモーター抵抗を取得 [Ω] */
+  const Amount &GetResistance() const;
+  /* 許容電流を取得 [A] (予測時間流し続けても上限温度を超えない電流) */
+  const Amount &GetCurrentLimit() const;
+
+ private:
+  Amount temperature_{kMotorAmbientTemperature, kMotorAmbientTemperature}; /* 推定温度 [℃] */
+  Amount resistance_{kMotorResistance, kMotorResistance};                 /* モーター抵抗 [Ω] */
+  Amount currentLimit_{kMotorCurrentLimit, kMotorCurrentLimit};           /* 許容電流 [A] */
+};
+}  // namespace PowerMonitoring
+
+#endif  // POWERMONITORING_MOTORTHERMAL_H_
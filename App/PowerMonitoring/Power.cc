@@ -1,6 +1,7 @@
 #include "PowerMonitoring/Power.h"
 
 /* C++ */
+#include <algorithm>
 #include <mutex>
 
 /* Project */
@@ -13,6 +14,9 @@ void PowerImpl::Reset() {
   batteryVoltageMovingAverage_.Reset();
   batteryVoltage_ = 0.0f;
   motorCurrent_ = {0.0f, 0.0f};
+  motorVoltage_ = {0.0f, 0.0f};
+  batteryModelInitialized_ = false;
+  motorThermal_.Reset();
   batteryErrorCount_ = 0;
   prevTick_ = HAL_GetTick();
 }
@@ -48,11 +52,10 @@ bool PowerImpl::Update() {
     } else {
       batteryErrorCount_++;
     }
-    float right = (2.0f * voltage[PowerAdc::kOrderMotorCurrentRight] - kRegulatorVoltage) /
-                  (kMotorCurrentMeasureDivResistor / 10000.0f);
-    float left = (2.0f * voltage[PowerAdc::kOrderMotorCurrentLeft] - kRegulatorVoltage) /
-                 (kMotorCurrentMeasureDivResistor / 10000.0f);
-    motorCurrent_ = {right, left};
+    motorCurrent_ = {PowerAdc::ConvertMotorCurrent(adc.GetRaw(PowerAdc::kOrderMotorCurrentRight)),
+                     PowerAdc::ConvertMotorCurrent(adc.GetRaw(PowerAdc::kOrderMotorCurrentLeft))};
+    UpdateBatteryModel();
+    motorThermal_.Update(motorCurrent_);
     prevTick_ = tick;
   }
   return true;
@@ -70,6 +73,62 @@ PowerImpl::MotorCurrent PowerImpl::GetMotorCurrent() const {
   return motorCurrent_;
 }
 
+/* モーター電圧指令を設定 */
+void PowerImpl::SetMotorVoltage(const MotorVoltage &voltage) {
+  std::scoped_lock<Mutex> lock(mtx_);
+  motorVoltage_ = voltage;
+}
+
+/* 推定したバッテリー開放電圧を取得 */
+float PowerImpl::GetOpenCircuitVoltage() const {
+  std::scoped_lock<Mutex> lock(mtx_);
+  return batteryModelInitialized_ ? batteryModel_.Get()[0] : 0.0f;
+}
+
+/* 推定したバッテリー内部抵抗を取得 */
+float PowerImpl::GetInternalResistance() const {
+  std::scoped_lock<Mutex> lock(mtx_);
+  return batteryModelInitialized_ ? std::max(batteryModel_.Get()[1], 0.0f) : kBatteryInternalResistance;
+}
+
+/* 推定したモーター温度を取得 */
+PowerImpl::MotorCurrent PowerImpl::GetMotorTemperature() const {
+  std::scoped_lock<Mutex> lock(mtx_);
+  return motorThermal_.GetTemperature();
+}
+
+/* 温度補正したモーター抵抗を取得 */
+PowerImpl::MotorCurrent PowerImpl::GetMotorResistance() const {
+  std::scoped_lock<Mutex> lock(mtx_);
+  return motorThermal_.GetResistance();
+}
+
+/* 温度で低減したモーター許容電流を取得 */
+PowerImpl::MotorCurrent PowerImpl::GetMotorCurrentLimit() const {
+  std::scoped_lock<Mutex> lock(mtx_);
+  return motorThermal_.GetCurrentLimit();
+}
+
+/* バッテリーモデルを更新 (ロック中に呼び出す) */
+void PowerImpl::UpdateBatteryModel() {
+  static constexpr float dt = kPeriodicNotifyInterval;
+  static constexpr float kQ00 = kBatteryModelOcvDrift * kBatteryModelOcvDrift * dt;
+  static constexpr float kQ11 = kBatteryModelResistanceDrift * kBatteryModelResistanceDrift * dt;
+  static constexpr float kR = kBatteryModelVoltageNoise * kBatteryModelVoltageNoise;
+  if (batteryVoltage_ <= 0.0f) {
+    return;
+  }
+  if (!batteryModelInitialized_) {
+    batteryModel_.Reset({batteryVoltage_, kBatteryInternalResistance}, {{{kR, 0.0f}, {0.0f, 0.05f * 0.05f}}});
+    batteryModelInitialized_ = true;
+    return;
+  }
+  /* モーターに供給した電力からバッテリー電流を求める */
+  float current = (motorVoltage_[0] * motorCurrent_[0] + motorVoltage_[1] * motorCurrent_[1]) / batteryVoltage_;
+  batteryModel_.Predict({{{1.0f, 0.0f}, {0.0f, 1.0f}}}, {0.0f, 0.0f}, {{{kQ00, 0.0f}, {0.0f, kQ11}}});
+  batteryModel_.Correct({1.0f, -1.0f * current}, batteryVoltage_, kR);
+}
+
 /* 電池エラー連続時間 [ms] を取得 */
 uint32_t PowerImpl::GetBatteryErrorTime() const { return batteryErrorCount_; }
 
@@ -3,7 +3,9 @@
 
 /* Projects */
 #include "Config.h"
+#include "Data/KalmanFilter.h"
 #include "Data/MovingAverage.h"
+#include "PowerMonitoring/MotorThermal.h"
 #include "Wrapper/Mutex.h"
 
 /* C++ */
@@ -13,6 +15,7 @@ namespace PowerMonitoring {
 class PowerImpl {
  public:
   using MotorCurrent = std::array<float, 2>;
+  using MotorVoltage = std::array<float, 2>;
 
   /* リセット */
   void Reset();
@@ -29,6 +32,21 @@ class PowerImpl {
   /* モーター電流を取得 */
   MotorCurrent GetMotorCurrent() const;
 
+  /* モーター電圧指令を設定 (バッテリー電流の推定に使う) */
+  void SetMotorVoltage(const MotorVoltage &voltage);
+
+  /* 推定したバッテリー開放電圧を取得 [V] (未推定なら0) */
+  float GetOpenCircuitVoltage() const;
+  /* 推定したバッテリー内部抵抗を取得 [Ω] */
+  float GetInternalResistance() const;
+
+  /* 推定したモーター温度を取得 [℃] */
+  MotorCurrent GetMotorTemperature() const;
+  /* 温度補正したモーター抵抗を取得 [Ω] */
+  MotorCurrent GetMotorResistance() const;
+  /* 温度で低減したモーター許容電流を取得 [A] */
+  MotorCurrent GetMotorCurrentLimit() const;
+
   /* 電池エラー連続時間 [ms] を取得 */
   uint32_t GetBatteryErrorTime() const;
 
@@ -47,6 +65,17 @@ class PowerImpl {
   float batteryVoltage_{0.0f};            /* 電池電圧 [V] */
   uint32_t batteryErrorCount_{0};         /* 連続異常カウント */
   MotorCurrent motorCurrent_{0.0f, 0.0f}; /* 計測モーター電流 [A] */
+  MotorVoltage motorVoltage_{0.0f, 0.0f}; /* モーター電圧指令 [V] */
+
+  /* バッテリーモデル (電圧 = 開放電圧 - 内部抵抗 × 電流) */
+  KalmanFilter2<float> batteryModel_{}; /* 状態は開放電圧 [V] と内部抵抗 [Ω] */
+  bool batteryModelInitialized_{false};
+
+  /* モーター温度モデル (リセットしないので走行をまたいで温度を引き継ぐ) */
+  MotorThermal motorThermal_{};
+
+  /* バッテリーモデルを更新 */
+  void UpdateBatteryModel();
   uint32_t prevTick_{0};
   uint32_t diffTick_{0};
 };
@@ -16,22 +16,27 @@ PowerAdc::PowerAdc() : adc2Semphr_(xSemaphoreCreateBinaryStatic(&adc2SemphrBuffe
 
 /* 初期化 */
 bool PowerAdc::Initialize() {
-  return HAL_ADC_RegisterCallback(&hadc2, HAL_ADC_CONVERSION_COMPLETE_CB_ID, Adc2ConvCpltCallback) == HAL_OK;
+  /* ADC2 は電流制御のインジェクテッド変換と共用する */
+  /* HAL_ADC_Stop_DMA はインジェクテッド変換も止めてADCを無効にするので、DMAは循環モードで一度だけ開始して止めない */
+  /* (DMA循環モードは rt-linelight_v2.ioc で設定) */
+  if (HAL_ADC_RegisterCallback(&hadc2, HAL_ADC_CONVERSION_COMPLETE_CB_ID, Adc2ConvCpltCallback) != HAL_OK) {
+    return false;
+  }
+  return HAL_ADC_Start_DMA(&hadc2, reinterpret_cast<uint32_t *>(adc2Buffer_), kNumOrder) == HAL_OK;
 }
 
 /* 値を更新 */
 bool PowerAdc::Fetch() {
-  if (HAL_ADC_Start_DMA(&hadc2, reinterpret_cast<uint32_t *>(adc2Buffer_), kNumOrder) == HAL_OK) {
-    /* TODO: タイムアウト */
-    if (xSemaphoreTake(adc2Semphr_, pdMS_TO_TICKS(1)) == pdTRUE) {
-      if (HAL_ADC_Stop_DMA(&hadc2) == HAL_OK) {
-        /* キャッシュラインを更新 */
-        SCB_CleanInvalidateDCache_by_Addr((uint32_t *)adc2Buffer_, sizeof(adc2Buffer_));
-        return true;
-      }
-    }
+  /* 前回までの完了通知(開始時の1回分)は捨てる */
+  xSemaphoreTake(adc2Semphr_, 0);
+  /* レギュラー変換を1回だけ開始 (ハンドルの状態は変えないので割り込み側の処理と競合しない) */
+  LL_ADC_REG_StartConversion(hadc2.Instance);
+  if (xSemaphoreTake(adc2Semphr_, pdMS_TO_TICKS(1)) != pdTRUE) {
+    return false;
   }
-  return false;
+  /* キャッシュラインを更新 */
+  SCB_CleanInvalidateDCache_by_Addr((uint32_t *)adc2Buffer_, sizeof(adc2Buffer_));
+  return true;
 }
 
 /* 値を取得 */
@@ -38,6 +38,12 @@ class PowerAdc final : public Singleton<PowerAdc> {
   /* 値を取得 */
   uint16_t GetRaw(uint32_t order);
 
+  /* モーター電流計測値を電流に変換 [A] */
+  static float ConvertMotorCurrent(uint32_t raw) {
+    float voltage = static_cast<float>(raw) * kAdcReferenceVoltage / static_cast<float>(kAdcMaxValue);
+    return (2.0f * voltage - kRegulatorVoltage) / (kMotorCurrentMeasureDivResistor / 10000.0f);
+  }
+
  private:
   /* ADC2 完了割り込み */
   static void Adc2ConvCpltCallback(ADC_HandleTypeDef *);
@@ -8,6 +8,7 @@
 
 /* Project */
 #include "Config.h"
+#include "FaultManager.h"
 #include "Periodic.h"
 #include "PowerMonitoring/PowerAdc.h"
 
@@ -37,9 +38,12 @@ void PowerMonitoring::TaskEntry() {
       if (!power_.Update()) {
         /* TODO: エラー時 */
       }
-      if (power_.GetAdcErrorTime() >= kPowerAdcErrorTime || power_.GetBatteryErrorTime() >= kBatteryErrorTime) {
-        /* 一定時間以上異常の場合はリセット */
-        NVIC_SystemReset();
+      /* 一定時間以上異常の場合は履歴を残してリセット */
+      if (power_.GetAdcErrorTime() >= kPowerAdcErrorTime) {
+        FaultManager::Instance().Raise(FaultCode::kPowerAdc);
+      }
+      if (power_.GetBatteryErrorTime() >= kBatteryErrorTime) {
+        FaultManager::Instance().Raise(FaultCode::kBattery);
       }
     }
   }
@@ -16,6 +16,9 @@ class PowerMonitoring final : public Task<PowerMonitoring> {
   /* 状態を取得 */
   const PowerImpl &Power() { return power_; }
 
+  /* モーター電圧指令を設定 */
+  void SetMotorVoltage(const PowerImpl::MotorVoltage &voltage) { power_.SetMotorVoltage(voltage); }
+
  protected:
   /* タスク */
   void TaskEntry() final;
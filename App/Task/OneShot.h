@@ -1,7 +1,11 @@
 #ifndef TASK_ONESHOTTASK_H_
 #define TASK_ONESHOTTASK_H_
 
+/* C++ */
+#include <mutex>
+
 /* Project */
+#include "Wrapper/Mutex.h"
 #include "Wrapper/Task.h"
 
 /**
@@ -18,14 +22,15 @@ class OneShot : public Task<Class> {
   }
 
  protected:
-  /* リクエスト送信 */
-  bool Send(const Request &request, TickType_t xTicksToWait = portMAX_DELAY) {
-    return xQueueSend(requestQueue_, &request, xTicksToWait) == pdTRUE;
-  }
-
-  /* 結果を取得 */
-  bool Receive(Response &response, TickType_t xTicksToWait = portMAX_DELAY) {
-    return xQueueReceive(responseQueue_, &response, xTicksToWait) == pdTRUE;
+  /* リクエストを送信して結果を取得 */
+  /* レスポンスキューは全クライアントで共有なので、送信から受信までを排他して他の要求の結果を受け取らないようにする */
+  /* 送信できた要求の結果は必ず受け取る (待ち時間は送信までに適用する) */
+  bool Transact(const Request &request, Response &response, TickType_t xTicksToWait = portMAX_DELAY) {
+    std::scoped_lock<Mutex> lock(clientMtx_);
+    if (xQueueSend(requestQueue_, &request, xTicksToWait) != pdTRUE) {
+      return false;
+    }
+    return xQueueReceive(responseQueue_, &response, portMAX_DELAY) == pdTRUE;
   }
 
   /* 要求時コールバック */
@@ -44,6 +49,7 @@ class OneShot : public Task<Class> {
   }
 
  private:
+  Mutex clientMtx_;
   uint8_t requestQueueQueueStorageBuffer_[sizeof(Request)];
   StaticQueue_t requestQueueBuffer_;
   QueueHandle_t requestQueue_;
@@ -16,6 +16,9 @@
 #include "Ui.h"
 
 /* C++ */
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <cstdio>
 #include <cstring>
 
@@ -41,6 +44,7 @@ static void TestVelocityMeasure() {
     printf("acc: %f, %f\r\n", acc.trans, acc.rot);
     printf("vel: %f, %f\r\n", vel.trans, vel.rot);
     printf("disp: %f, %f\r\n", dis.trans, dis.rot);
+    printf("estimator: %lu cycles\r\n", odometry.GetEstimatorCycles());
   }
   MotionSensing::MotionSensing::Instance().NotifyStop();
 }
@@ -48,7 +52,7 @@ static void TestVelocityMeasure() {
 static void TestEnkaigei() {
   auto &ui = Ui::Instance();
   auto &servo = MotionPlaning::MotionPlaning::Instance().Servo();
-  servo.SetGain({0.5f, 0.00f, 0.0f}, {0.3f, 0.05f, 0.0f});
+  servo.SetGain({0.5f, 0.0f, 0.0f}, {0.3f, 50.0f, 0.0f});
 
   /* IMUキャリブレーション */
   if (!MotionSensing::MotionSensing::Instance().CalibrateImu(1000)) {
@@ -93,8 +97,8 @@ static void TestStraight() {
   TestStraightLog testLog = {};
   uint32_t logAddr = 0;
   uint32_t t = 0;
-  SlopeVelocityGenerator generator;
-  SlopeVelocityGenerator::Profile profile = {0.0f, 0.5f, 0.0f, 1.0f, -1.0f, 1.0f};
+  SCurveVelocityGenerator generator;
+  SCurveVelocityGenerator::Profile profile = {0.0f, 0.5f, 0.0f, 1.0f, -1.0f, 10.0f, 1.0f};
   auto &odometry = MotionSensing::MotionSensing::Instance().Odometry();
   auto &servo = MotionPlaning::MotionPlaning::Instance().Servo();
   auto &power = PowerMonitoring::PowerMonitoring::Instance().Power();
@@ -105,7 +109,7 @@ static void TestStraight() {
   generator.Generate(profile);
   printf("Total: %ld ms\r\n", generator.GetTotalTime());
 
-  servo.SetGain({5.0f, 0.01f, 0.0f}, {0.3f, 0.05f, 0.0f});
+  servo.SetGain({5.0f, 10.0f, 0.0f}, {0.3f, 50.0f, 0.0f});
   /* IMUキャリブレーション */
   if (!MotionSensing::MotionSensing::Instance().CalibrateImu(1000)) {
     ui.Warn();
@@ -168,13 +172,14 @@ static void TestTurn() {
   TestTurnLog testLog = {};
   uint32_t logAddr = 0;
   uint32_t t = 0;
-  SlopeVelocityGenerator generator;
-  SlopeVelocityGenerator::Profile profile = {0.0f,
-                                             static_cast<float>(M_PI) / 2.0f,
-                                             0.0f,
-                                             static_cast<float>(M_PI),
-                                             -1.0f * static_cast<float>(M_PI),
-                                             static_cast<float>(M_PI) * 2.0f};
+  SCurveVelocityGenerator generator;
+  SCurveVelocityGenerator::Profile profile = {0.0f,
+                                              static_cast<float>(M_PI) / 2.0f,
+                                              0.0f,
+                                              static_cast<float>(M_PI),
+                                              -1.0f * static_cast<float>(M_PI),
+                                              static_cast<float>(M_PI) * 10.0f,
+                                              static_cast<float>(M_PI) * 2.0f};
   auto &odometry = MotionSensing::MotionSensing::Instance().Odometry();
   auto &servo = MotionPlaning::MotionPlaning::Instance().Servo();
   auto &power = PowerMonitoring::PowerMonitoring::Instance().Power();
@@ -185,7 +190,7 @@ static void TestTurn() {
   generator.Generate(profile);
   printf("Total: %ld ms\r\n", generator.GetTotalTime());
 
-  servo.SetGain({0.0f, 0.0f, 0.0f}, {0.3f, 0.05f, 0.0f});
+  servo.SetGain({0.0f, 0.0f, 0.0f}, {0.3f, 50.0f, 0.0f});
   /* IMUキャリブレーション */
   if (!MotionSensing::MotionSensing::Instance().CalibrateImu(1000)) {
     ui.Warn();
@@ -405,7 +410,7 @@ static void TestLineFollow() {
   uint32_t count = 0;
   Pid pid{};
   pid.Reset({3.5f, 0.0f, 0.01f});
-  servo.SetGain({0.0f, 0.00f, 0.0f}, {0.3f, 0.05f, 0.0f});
+  servo.SetGain({0.0f, 0.0f, 0.0f}, {0.3f, 50.0f, 0.0f});
   /* IMUキャリブレーション */
   if (!MotionSensing::MotionSensing::Instance().CalibrateImu(1000)) {
     ui.Warn();
@@ -423,7 +428,7 @@ static void TestLineFollow() {
     }
 
     auto error = line.GetError();
-    auto angVelo = pid.Update(0, error, kPeriodicNotifyInterval);
+    auto angVelo = pid.Update(0, error);
     servo.SetTarget(0, angVelo);
     if (++count >= 100) {
       count = 0;
@@ -435,6 +440,105 @@ static void TestLineFollow() {
   MotionSensing::MotionSensing::Instance().NotifyStop();
   MotionPlaning::MotionPlaning::Instance().NotifyStop();
 }
+/* 摩擦同定 (車体を浮かせて車輪を空転させる) */
+static void TestFrictionIdentify() {
+  using Amount = MotionPlaning::ServoImpl::ControlAmount;
+  static constexpr std::array<float, 4> kSteadyVoltages = {1.0f, 1.5f, 2.0f, 2.5f}; /* 粘性摩擦の同定電圧 [V] */
+  static constexpr uint32_t kSteadyTime = 1000;                                      /* 各電圧の印加時間 [ms] */
+  static constexpr uint32_t kAverageTime = 500;                                      /* 速度を平均する時間 [ms] */
+  auto &ui = Ui::Instance();
+  auto &motor = MotionPlaning::Motor::Instance();
+  auto &encoder = MotionSensing::Encoder::Instance();
+  auto &power = PowerMonitoring::PowerMonitoring::Instance().Power();
+
+  printf("Lift the machine so that both wheels spin freely.\r\n");
+  vTaskDelay(pdMS_TO_TICKS(1000));
+  MotionSensing::MotionSensing::Instance().NotifyStart();
+  motor.Enable();
+  auto xLastWakeTime = xTaskGetTickCount();
+  /* 1周期待って電圧を出力 (ボタンで中断) */
+  auto step = [&](const Amount &voltage) {
+    vTaskDelayUntil(&xLastWakeTime, pdMS_TO_TICKS(1));
+    float battery = power.GetBatteryVoltage();
+    motor.SetDuty({voltage[0] / battery, voltage[1] / battery});
+    return ui.WaitPress(0) < kButtonShortPressThreshold;
+  };
+  auto wheelSpeed = [&]() {
+    auto omega = encoder.GetVelocity();
+    return Amount{std::abs(omega[0]) * kWheelRadius, std::abs(omega[1]) * kWheelRadius};
+  };
+
+  /* 起動電圧: 正転・逆転それぞれで電圧を少しずつ上げ、車輪が回り始めた電圧を平均する */
+  bool success = true;
+  Amount breakaway{};
+  for (float direction : {1.0f, -1.0f}) {
+    Amount voltage{};
+    std::array<bool, 2> moved{false, false};
+    while (success && !(moved[0] && moved[1])) {
+      auto speed = wheelSpeed();
+      for (int i = 0; i < 2; i++) {
+        if (moved[i]) {
+          continue;
+        }
+        if (speed[i] >= kFrictionStaticVelocity) {
+          moved[i] = true;
+          breakaway[i] += std::abs(voltage[i]) / 2.0f;
+          voltage[i] = 0.0f;
+        } else {
+          voltage[i] += direction * kFrictionIdentRampRate * kPeriodicNotifyInterval;
+        }
+      }
+      success = std::abs(voltage[0]) < kFrictionIdentMaxVoltage && std::abs(voltage[1]) < kFrictionIdentMaxVoltage &&
+                step(voltage);
+    }
+    for (uint32_t t = 0; success && t < kSteadyTime; t++) {
+      success = step({0.0f, 0.0f});
+    }
+  }
+
+  /* 粘性摩擦: 一定電圧で空転させたときの (電圧 - 逆起電力) を速度の一次式で近似する */
+  Amount sumV{}, sumR{}, sumVV{}, sumVR{};
+  for (float v : kSteadyVoltages) {
+    Amount sumSpeed{};
+    for (uint32_t t = 0; success && t < kSteadyTime; t++) {
+      success = step({v, v});
+      if (t >= kSteadyTime - kAverageTime) {
+        auto speed = wheelSpeed();
+        sumSpeed[0] += speed[0];
+        sumSpeed[1] += speed[1];
+      }
+    }
+    for (int i = 0; i < 2; i++) {
+      float speed = sumSpeed[i] / static_cast<float>(kAverageTime);
+      float residual = v - kBackEmfPerVelocity * speed;
+      sumV[i] += speed;
+      sumR[i] += residual;
+      sumVV[i] += speed * speed;
+      sumVR[i] += speed * residual;
+    }
+  }
+  motor.Brake();
+  motor.Disable();
+  MotionSensing::MotionSensing::Instance().NotifyStop();
+
+  Amount coulomb{}, viscous{};
+  constexpr float n = static_cast<float>(kSteadyVoltages.size());
+  for (int i = 0; i < 2; i++) {
+    float denominator = n * sumVV[i] - sumV[i] * sumV[i];
+    float slope = denominator > 0.0f ? (n * sumVR[i] - sumV[i] * sumR[i]) / denominator : 0.0f;
+    float intercept = (sumR[i] - slope * sumV[i]) / n;
+    coulomb[i] = std::max(intercept, 0.0f);
+    viscous[i] = std::max(slope, 0.0f);
+  }
+  printf("breakaway: %f, %f [V]\r\n", breakaway[0], breakaway[1]);
+  printf("coulomb: %f, %f [V]\r\n", coulomb[0], coulomb[1]);
+  printf("viscous: %f, %f [V/(m/s)]\r\n", viscous[0], viscous[1]);
+  if (!success || !MotionPlaning::MotionPlaning::Instance().StoreFriction(breakaway, coulomb, viscous)) {
+    ui.Warn();
+    return;
+  }
+  ui.SetBuzzer(kBuzzerFrequency, kBuzzerEnterDuration);
+}
 /* テスト用モードセレクト */
 void TestSelectMode() {
   /* モード選択 */
@@ -483,6 +587,9 @@ void TestSelectMode() {
       case 0x0d:
         TestLineFollow();
         break;
+      case 0x0e:
+        TestFrictionIdentify();
+        break;
       case 0x0f:
         return; /* メインに戻る */
       default:
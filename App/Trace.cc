@@ -2,6 +2,7 @@
 
 /* Project */
 #include "Config.h"
+#include "FaultManager.h"
 #include "NonVolatileData.h"
 #include "Periodic.h"
 
@@ -9,6 +10,7 @@
 #include <FreeRTOS.h>
 
 /* C++ */
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 
@@ -38,8 +40,18 @@ void Trace::Run(const Parameter &param) {
   state_ = kStateResetting;
   resetCount_ = 0;
   param_ = param;
-  lineErrorPid_.Reset(param_.lineErrorGain);
-  servo_->SetGain(param_.linearGain, param_.angularGain);
+  lineErrorPid_.Reset(param_.lineErrorGain.Get(0.0f));
+  lineErrorPid_.SetDerivativeFilter(kLineErrorDerivativeTimeConstant);
+  lineErrorPid_.SetLimit(-kLineErrorMaxAngularVelocity, kLineErrorMaxAngularVelocity);
+  lateral_.Reset();
+  recovery_.Stop();
+  servo_->SetGainSchedule(param_.linearGain, param_.angularGain);
+
+  /* 状態フィードバックは横ずれへの換算を同定していないと使えない */
+  if (param_.lateralControl && !line_->HasOffsetGain()) {
+    ui_->Warn();
+    return;
+  }
 
   if (param_.mode == Mode::kSearchRunning) {
     /* 既に探索済みの場合は警告 */
@@ -57,13 +69,18 @@ void Trace::Run(const Parameter &param) {
       return;
     }
     velocityMap_.ResetFastRunning();
+    /* 吸引電圧は区間ごとに計画する */
+    if (!velocityMap_.CalculateSuctionTable(param_.suctionMinVoltage, param_.suctionVoltage)) {
+      ui_->Warn();
+      return;
+    }
   }
 
   /* 手が離れるまで待つ */
   vTaskDelay(pdMS_TO_TICKS(1000));
 
-  /* IMUキャリブレーション */
-  if (!ms_->CalibrateImu(1000)) {
+  /* IMUバイアス設定 (保存済みの温度別バイアスが無ければキャリブレーション) */
+  if (!ms_->PrepareImu()) {
     ui_->Warn();
     return;
   }
@@ -101,6 +118,14 @@ void Trace::Run(const Parameter &param) {
   ls_->NotifyStop();
   ms_->NotifyStop();
   NonVolatileData::WriteLogDataNumBytes(logBytes_);
+  ms_->StoreImuBias(); /* 静止中に再推定したバイアスを保存 */
+  if (param_.mode == Mode::kFastRunning) {
+    /* 地図と合わずに捨てた検出 */
+    auto rejected = marker_->GetRejectedCount();
+    printf("Rejected: goal marker %ld, curvature marker %ld, correction %d (last confidence %.2f)\r\n", rejected[0],
+           rejected[1], velocityMap_.GetFastRunningRejectedCount(),
+           static_cast<double>(velocityMap_.GetFastRunningCorrectionConfidence()));
+  }
   if (state_ == kStateEmergencyStop) {
     ui_->Warn();
   } else if (state_ == kStateGoaledStopped) {
@@ -165,7 +190,8 @@ void Trace::UpdateState() {
     case kStateGoaledStopWaiting:
       /* ゴール後減速中 */
       OnGoaledStopWaiting();
-      if (velocity_ < 0.01f) {
+      /* ブレーキは指令速度(移動平均後)が止まってからかける */
+      if (commandVelocity_ < 0.01f) {
         state_ = kStateGoaledStopped;
         OnGoaledStopped();
       }
@@ -187,6 +213,9 @@ void Trace::OnResetting() {
   suction_->Enable();
   velocity_ = 0.0f;
   acceleration_ = 0.0f;
+  curvature_ = 0.0f;
+  velocitySmoother_.Reset();
+  commandVelocity_ = 0.0f;
 
   /* ログ */
   logFrequencyCount_ = 0;
@@ -222,17 +251,25 @@ void Trace::OnGoalWaiting() {
     /* 距離と距離単位あたりの角度を保存 */
     auto totalDistance = odometry_->GetDisplacement().trans;
     velocityMap_.UpdateSearchRunningCurvePoint(deltaDistance, odometry_->GetVelocity().rot);
-    if (marker_->IsCurvature()) { /* とりあえず曲率マーカーを優先 どっちの方が正確？ */
+    /* 補正点は車軸が通過した位置で記録する */
+    if (marker_->IsCurvatureAtAxle()) { /* とりあえず曲率マーカーを優先 どっちの方が正確？ */
       velocityMap_.AddSearchRunningCorrectPoint(CorrectType::kCurveMarker, totalDistance);
-    } else if (line_->IsCrossPassed()) {
+    } else if (line_->IsCrossPassedAtAxle()) {
       velocityMap_.AddSearchRunningCorrectPoint(CorrectType::kCrossLine, totalDistance);
     }
   } else if (param_.mode == Mode::kFastRunning) {
     /* 走行制御 */
     /* 最短時は生成したテーブルから速度を索引 */
-    velocityMap_.UpdateFastRunning(deltaDistance, line_->IsCrossPassed(), marker_->IsCurvature());
+    velocityMap_.UpdateFastRunning(deltaDistance, line_->IsCrossPassedAtAxle(), marker_->IsCurvatureAtAxle());
+    /* 地図から予想されるマーカー位置の前後だけ検出を受け付ける (曲率マーカーはセンサー位置で予想する) */
+    ls_->SetMarkerGate({
+        velocityMap_.IsFastRunningGoalExpected(kCorrectionGoalWindow, kCorrectionGoalWindowGrowth),
+        velocityMap_.IsFastRunningCorrectionExpected(CorrectType::kCurveMarker, kMarkerDistanceFromCenter,
+                                                     kCorrectionAllowErrorCurvature),
+    });
     float now = 0.0f, next = 0.0f;
-    velocityMap_.GetFastRunningVelocity(now, next);
+    /* 移動平均の遅れ分だけ先の速度を索引する */
+    velocityMap_.GetFastRunningVelocity(now, next, velocity_ * kVelocitySmoothingDelay);
     if (now < next) {
       minVelocity_ = next;
       maxVelocity_ = now;
@@ -242,20 +279,26 @@ void Trace::OnGoalWaiting() {
       maxVelocity_ = next;
       acceleration_ = param_.acceleration;
     }
+    /* 曲率FF用に、センサー位置と旋回の遅れ分だけ先の曲率を索引 */
+    float lookahead = kCurvatureFeedForwardOffset + velocity_ * kCurvatureFeedForwardDelay;
+    curvature_ = velocityMap_.GetFastRunningCurvature(lookahead, kCurvatureFeedForwardWindow);
   }
 }
 /* 緊急状態かどうか */
 bool Trace::CheckEmergency() {
-  if (ui_->WaitPress(0)) { /* ボタンが押されている */
-    return true;
-  } else if (line_->IsNone()) { /* ラインが見えない */
-    return true;
-  } else if (power_->GetBatteryErrorTime() > kBatteryErrorTime) { /* バッテリーエラー */
-    return true;
-  } else if (servo_->IsEmergency()) { /* サーボでエラー */
+  auto &fault = FaultManager::Instance();
+  if (ui_->WaitPress(0)) { /* ボタンが押されている (フォールトではない) */
     return true;
   }
-  return false;
+  if (line_->IsNone() && /* 復帰できる距離を超えてもラインが見えない */
+      recovery_.GetLostDistance(odometry_->GetDisplacement().trans) >= kCourseOutRecoveryDistance) {
+    fault.Raise(FaultCode::kLineLost);
+  }
+  if (power_->GetBatteryErrorTime() > kBatteryErrorTime) { /* バッテリーエラー */
+    fault.Raise(FaultCode::kBattery);
+  }
+  /* サーボ・モータードライバなど他で検出したフォールトもラッチされている */
+  return fault.IsStopRequired() || servo_->IsEmergency();
 }
 /* ゴールマーカー通過 */
 void Trace::OnGoaled() {
@@ -268,8 +311,11 @@ void Trace::OnGoaled() {
   }
 
   /* 走行制御 */
+  curvature_ = 0.0f;
   minVelocity_ = 0.0f;
-  acceleration_ = CalculateDeceleration(velocity_, param_.stopDistance);
+  /* 指令速度は移動平均で遅れる分だけ余計に進むので、その距離を差し引いて減速する */
+  float distance = std::max(param_.stopDistance - velocity_ * kVelocitySmoothingDelay, param_.stopDistance / 2.0f);
+  acceleration_ = CalculateDeceleration(velocity_, distance);
 }
 /* 減速中 */
 void Trace::OnGoaledStopWaiting() {}
@@ -277,21 +323,98 @@ void Trace::OnGoaledStopWaiting() {}
 void Trace::OnGoaledStopped() {
   acceleration_ = 0.0f;
   velocity_ = 0.0f;
+  /* 残った速度は電流制限付きの短絡ブレーキで止める */
+  servo_->SetActiveBrake(true);
 }
 
 /* 走行制御を更新 */
 void Trace::UpdateMotion() {
   /* 必要があれば吸引ファンを回す */
   if (param_.suctionVoltage != 0.0f) {
-    suction_->SetDuty(param_.suctionVoltage / power_->GetBatteryVoltage());
+    /* 最短時は直線で弱め、カーブ・加減速の手前から強める */
+    float voltage = param_.mode == Mode::kFastRunning ? velocityMap_.GetFastRunningSuctionVoltage()
+                                                      : param_.suctionVoltage;
+    suction_->SetDuty(voltage / power_->GetBatteryVoltage());
+  }
+  /* コースアウト中は延長したラインへ戻す */
+  UpdateRecovery();
+  float maxVelocity = maxVelocity_;
+  float minVelocity = minVelocity_;
+  if (recovery_.IsActive()) {
+    /* 復帰速度まで減速して保つ */
+    maxVelocity = std::max(kCourseOutRecoveryVelocity,
+                           velocity_ - kCourseOutRecoveryDeceleration * kPeriodicNotifyInterval);
+    minVelocity = std::min(minVelocity, maxVelocity);
   }
   /* 設定された制限速度を元に加減速した速度を計算 */
-  velocity_ += acceleration_ * kPeriodicNotifyInterval;
-  velocity_ = std::min(std::max(velocity_, minVelocity_), maxVelocity_);
+  if (odometry_->IsSlipping()) {
+    /* スリップ中は加減速を弱め、目標速度を推定速度の近くに留めて駆動力を抑える */
+    float estimate = odometry_->GetVelocity().trans;
+    velocity_ += acceleration_ * kTractionAccelerationScale * kPeriodicNotifyInterval;
+    velocity_ = std::clamp(velocity_, estimate - kTractionVelocityMargin, estimate + kTractionVelocityMargin);
+  } else {
+    velocity_ += acceleration_ * kPeriodicNotifyInterval;
+  }
+  velocity_ = std::min(std::max(velocity_, minVelocity), maxVelocity);
+  /* 台形の速度を移動平均して加速度の変化を制限する (躍度 = 加速度 / 移動平均の時間) */
+  float previousVelocity = commandVelocity_;
+  velocitySmoother_.Update(velocity_);
+  commandVelocity_ = velocitySmoother_.Get();
+  /* 減速中は短絡ブレーキで減衰させて制動力を確保し、それ以外は混合減衰で電流リプルを抑える */
+  servo_->SetDecay(commandVelocity_ < previousVelocity ? MotionPlaning::Motor::Decay::kSlow
+                                                       : MotionPlaning::Motor::Decay::kMixed);
   /* ライン追従角速度を計算 */
-  angularVelocity_ = lineErrorPid_.Update(0, line_->GetError(), kPeriodicNotifyInterval);
+  if (recovery_.IsActive()) {
+    /* 最後に見たラインを延長した経路へ姿勢で戻す */
+    angularVelocity_ = recovery_.Update(odometry_->GetPose(), odometry_->GetVelocity().trans);
+  } else if (param_.lateralControl) {
+    /* 横ずれと向きを推定して状態フィードバック */
+    auto velocity = odometry_->GetVelocity();
+    bool valid = line_->GetState() == LineSensing::LineImpl::State::kNormal;
+    angularVelocity_ = lateral_.Update(line_->GetOffset(), valid, velocity.trans, velocity.rot, curvature_);
+  } else {
+    /* コースアウト復帰に使う横ずれと向きは換算を同定していれば推定しておく */
+    if (line_->HasOffsetGain()) {
+      auto velocity = odometry_->GetVelocity();
+      bool valid = line_->GetState() == LineSensing::LineImpl::State::kNormal;
+      lateral_.Estimate(line_->GetOffset(), valid, velocity.trans, velocity.rot, GetLineCurvature());
+    }
+    /* ゲインは目標速度でスケジュール */
+    /* 最短時は曲率マップからFFし、PIDは残りの誤差のみ補正する */
+    lineErrorPid_.SetGain(param_.lineErrorGain.Get(commandVelocity_));
+    angularVelocity_ = commandVelocity_ * curvature_ + lineErrorPid_.Update(0, line_->GetError());
+  }
   /* 設定 */
-  servo_->SetTarget(velocity_, angularVelocity_);
+  servo_->SetTarget(commandVelocity_, angularVelocity_);
+}
+/* コースアウト復帰を更新 */
+void Trace::UpdateRecovery() {
+  auto state = line_->GetState();
+  if (state == LineSensing::LineImpl::State::kNormal) {
+    if (recovery_.IsActive()) {
+      /* 再検出したので通常の追従へ戻す (見失っていた間の誤差は捨てる) */
+      recovery_.Stop();
+      lineErrorPid_.Reset();
+      lateral_.Reset();
+      ui_->SetBuzzer(kBuzzerFrequency, kBuzzerCancelDuration);
+    }
+    /* 最後に見たラインの横ずれと向きを記録する (換算が未同定なら、ラインはセンサー位置を今の向きに通るとする) */
+    float heading = line_->HasOffsetGain() ? lateral_.GetHeading() : 0.0f;
+    recovery_.Record(odometry_->GetPose(), line_->GetOffset(), heading, GetLineCurvature(),
+                     odometry_->GetDisplacement().trans);
+  } else if (state == LineSensing::LineImpl::State::kNone && !recovery_.IsActive()) {
+    /* 交差で再検出した場合は交差を抜けて通常に戻るまで復帰を続ける */
+    recovery_.Start();
+    ui_->SetBuzzer(kBuzzerFrequency, kBuzzerEnterDuration);
+  }
+}
+/* ラインの曲率を取得 (最短時は曲率マップ、探索時は追従中の旋回から求める) */
+float Trace::GetLineCurvature() const {
+  if (param_.mode == Mode::kFastRunning) {
+    return curvature_;
+  }
+  auto velocity = odometry_->GetVelocity();
+  return velocity.rot / std::max(velocity.trans, kCourseOutRecoveryVelocity);
 }
 /* 現在の速度から指定距離で停止する加速度を計算 */
 float Trace::CalculateDeceleration(float velocity, float distance) {
@@ -317,7 +440,7 @@ void Trace::UpdateLog() {
     auto ms = marker_->GetState();
     log_.time = HAL_GetTick() - logStartTime_;                       /* 00 Time */
     log_.line = line_->GetState();                                   /* 01 Line State */
-    log_.commandVelocity = velocity_;                                /* 02 Command Velocity */
+    log_.commandVelocity = commandVelocity_;                         /* 02 Command Velocity */
     log_.estimateVelocity = vel.trans;                               /* 03 Estimate Velocity */
     log_.expectTranslate = vi;                                       /* 04 Expect Translate */
     log_.estimateTranslate = dis.trans;                              /* 05 Estimate Translate */
@@ -354,7 +477,16 @@ void Trace::LoadSearchRunningPoints() {
 /* 速度マップを計算 */
 void Trace::CalculateVelocityMap(const std::vector<float> &minRadius, const std::vector<float> &maxVelocity,
                                  float startVelocity, float acceleration, float deceleration) {
-  if (!velocityMap_.CalculatVelocityTable(minRadius, maxVelocity, startVelocity, acceleration, deceleration)) {
+  /* 現在の充電状態とモーター温度で出せる加速度を反映する */
+  auto resistance = power_->GetMotorResistance();
+  auto currentLimit = power_->GetMotorCurrentLimit();
+  MotionPlaning::VelocityMapping::DriveLimit limit = {
+      power_->GetOpenCircuitVoltage(),
+      power_->GetInternalResistance(),
+      std::max(resistance[0], resistance[1]),
+      std::min(currentLimit[0], currentLimit[1]),
+  };
+  if (!velocityMap_.CalculatVelocityTable(minRadius, maxVelocity, startVelocity, acceleration, deceleration, limit)) {
     ui_->Warn();
   }
 }
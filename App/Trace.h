@@ -5,10 +5,13 @@
 #include <FreeRTOS.h>
 
 /* Project */
+#include "Data/MovingAverage.h"
 #include "Data/Pid.h"
 #include "Data/Singleton.h"
 #include "Fram.h"
 #include "LineSensing/LineSensing.h"
+#include "MotionPlaning/LateralControl.h"
+#include "MotionPlaning/LineRecovery.h"
 #include "MotionPlaning/MotionPlaning.h"
 #include "MotionPlaning/Suction.h"
 #include "MotionPlaning/VelocityMapping.h"
@@ -29,16 +32,18 @@ class Trace : public Singleton<Trace> {
   };
   /* 走行パラメータ */
   struct Parameter {
-    Mode mode;               /* モード */
-    uint32_t logInterval;    /* ログ出力周期 [ms] */
-    float maxVelocity;       /* 探索上限速度・最短時初期速度 [m/s] */
-    float acceleration;      /* 加速度 [m/ss] */
-    float deceleration;      /* 最短時減速度 [m/ss] */
-    Pid::Gain linearGain;    /* 並進PIDゲイン */
-    Pid::Gain angularGain;   /* 旋回PIDゲイン */
-    Pid::Gain lineErrorGain; /* ライン追従PIDゲイン */
-    float stopDistance;      /* ゴールマーカーから停止までの距離 [m] */
-    float suctionVoltage;    /* 吸引電圧 [V] */
+    Mode mode;                     /* モード */
+    uint32_t logInterval;          /* ログ出力周期 [ms] */
+    float maxVelocity;             /* 探索上限速度・最短時初期速度 [m/s] */
+    float acceleration;            /* 加速度 [m/ss] */
+    float deceleration;            /* 最短時減速度 [m/ss] */
+    PidGainSchedule linearGain;    /* 並進PIDゲイン */
+    PidGainSchedule angularGain;   /* 旋回PIDゲイン */
+    PidGainSchedule lineErrorGain; /* ライン追従PIDゲイン */
+    bool lateralControl;           /* 横ずれ・向きの状態フィードバックでライン追従するか (要同定) */
+    float stopDistance;            /* ゴールマーカーから停止までの距離 [m] */
+    float suctionVoltage;          /* 吸引電圧 [V] */
+    float suctionMinVoltage;       /* 最短時の直線での吸引電圧 [V] */
   };
 
   /* コンストラクタ */
@@ -134,10 +139,21 @@ class Trace : public Singleton<Trace> {
   float acceleration_{0.0f};    /* 加速度 [m/ss] */
   float maxVelocity_{0.0f};     /* 上限速度 [m/s] */
   float minVelocity_{0.0f};     /* 下限速度 [m/s] */
-  float velocity_{0.0f};        /* 速度 [m/s] */
+  float velocity_{0.0f};        /* 速度 [m/s] (台形加減速) */
   float angularVelocity_{0.0f}; /* 角速度 [rad/s] */
+  float curvature_{0.0f};       /* 曲率マップから先読みした曲率 [1/m] */
   Pid lineErrorPid_{};          /* ライン追従PID */
 
+  /* 躍度制限 */
+  MovingAverage<float, float, kVelocitySmoothingNumPoints> velocitySmoother_{}; /* 目標速度の移動平均 */
+  float commandVelocity_{0.0f};                                                 /* 指令速度 [m/s] */
+
+  /* 横方向の状態フィードバック */
+  MotionPlaning::LateralControl lateral_{};
+
+  /* コースアウト復帰 */
+  MotionPlaning::LineRecovery recovery_{};
+
   /* ログ */
   Log log_{};                     /* ログ一時バッファ */
   uint32_t logFrequencyCount_{0}; /* ログ出力周期カウンタ */
@@ -170,6 +186,10 @@ class Trace : public Singleton<Trace> {
 
   /* 走行制御を更新 */
   void UpdateMotion();
+  /* コースアウト復帰を更新 */
+  void UpdateRecovery();
+  /* ラインの曲率を取得 [1/m] */
+  float GetLineCurvature() const;
   /* 現在の速度から指定距離で停止する加速度を計算 */
   static float CalculateDeceleration(float velocity, float distance);
 
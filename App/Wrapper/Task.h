@@ -13,7 +13,8 @@ enum TaskNotifyBit {
   kTaskNotifyBitStart = (0x01 << 0),
   kTaskNotifyBitStop = (0x01 << 1),
   kTaskNotifyBitPeriodic = (0x01 << 2),
-  kTaskNotifyBitLast = kTaskNotifyBitPeriodic,
+  kTaskNotifyBitFault = (0x01 << 3),
+  kTaskNotifyBitLast = kTaskNotifyBitFault,
 };
 static constexpr uint32_t kTaskNotifyBitMask = (kTaskNotifyBitLast << 1) - 1;
 
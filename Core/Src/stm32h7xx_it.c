@@ -74,6 +74,10 @@ extern UART_HandleTypeDef huart1;
 extern TIM_HandleTypeDef htim6;
 
 /* USER CODE BEGIN EV */
+extern TIM_HandleTypeDef htim3;
+extern TIM_HandleTypeDef htim4;
+extern ADC_HandleTypeDef hadc1;
+extern ADC_HandleTypeDef hadc2;
 
 /* USER CODE END EV */
 
@@ -414,5 +418,37 @@ void TIM23_IRQHandler(void)
 }
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief This function handles TIM3 global interrupt (left encoder capture).
+  */
+void TIM3_IRQHandler(void)
+{
+  HAL_TIM_IRQHandler(&htim3);
+}
+
+/**
+  * @brief This function handles TIM4 global interrupt (right encoder capture).
+  */
+void TIM4_IRQHandler(void)
+{
+  HAL_TIM_IRQHandler(&htim4);
+}
+
+/**
+  * @brief This function handles ADC1 and ADC2 global interrupts (motor current injected conversion).
+  */
+void ADC_IRQHandler(void)
+{
+  HAL_ADC_IRQHandler(&hadc1);
+  HAL_ADC_IRQHandler(&hadc2);
+}
+
+/**
+  * @brief This function handles EXTI line[9:5] interrupts (motor driver nFAULT).
+  */
+void EXTI9_5_IRQHandler(void)
+{
+  HAL_GPIO_EXTI_IRQHandler(DRV_NFAULT_Pin);
+}
 
 /* USER CODE END 1 */
@@ -0,0 +1,95 @@
+/* 65mの走行を模擬し、距離の積算で丸め誤差が蓄積しないこと・スリップ中も周期変位と走行距離が一致することを確認する */
+
+/* C++ */
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <numbers>
+
+/* Project */
+#include "Data/CompensatedSum.h"
+#include "Data/CountDistance.h"
+
+namespace {
+/* 機体と同じ換算 (車輪直径23mm、ギア比42/11、4逓倍1024パルス、左右カウントの和) */
+constexpr double kWheelRadius = 23.0e-3 / 2.0;
+constexpr double kPulsePerRev = 42.0 / 11.0 * 4.0 * 1024.0;
+constexpr double kDistancePerCount = 2.0 * std::numbers::pi * kWheelRadius / kPulsePerRev / 2.0;
+
+constexpr double kRunDistance = 65.0;          /* 走行距離 [m] */
+constexpr double kPeriod = 1.0e-3;             /* 周期 [s] */
+constexpr double kAllowError = 1.0e-5;         /* 許容誤差 (65m付近のfloatの刻みと同程度) [m] */
+constexpr double kExpectedFloatDrift = 1.0e-4; /* 単純なfloatの積算で少なくともこれだけずれる [m] */
+constexpr double kAllowSlipError = 1.0e-3;     /* スリップ区間を含む走行距離の許容誤差 [m] */
+
+int failures = 0;
+
+void Check(bool condition, const char *name, double value) {
+  std::printf("%-28s %.9f %s\n", name, value, condition ? "OK" : "NG");
+  if (!condition) {
+    failures++;
+  }
+}
+}  // namespace
+
+int main() {
+  CountDistance countDistance(kDistancePerCount);
+  CompensatedSum<float> compensated;
+  float naive = 0.0f;
+
+  /* 1.0 ~ 5.0 m/s で加減速しながら走る。真の位置は倍精度で持ち、エンコーダーは整数カウントを返す */
+  double position = 0.0;
+  int64_t countedTotal = 0;
+  for (uint32_t tick = 0; position < kRunDistance; tick++) {
+    double velocity = 3.0 + 2.0 * std::sin(static_cast<double>(tick) * kPeriod);
+    position += velocity * kPeriod;
+    auto total = static_cast<int64_t>(std::floor(position / kDistancePerCount));
+    auto delta = static_cast<int32_t>(total - countedTotal);
+    countedTotal = total;
+
+    /* 周期の変位 (従来はこれをfloatで積算していた) */
+    float deltaDistance = static_cast<float>(static_cast<double>(delta) * kDistancePerCount);
+    countDistance.Add(delta);
+    compensated += deltaDistance;
+    naive += deltaDistance;
+  }
+  double reference = static_cast<double>(countedTotal) * kDistancePerCount;
+
+  double naiveError = std::abs(static_cast<double>(naive) - reference);
+  double countError = std::abs(static_cast<double>(countDistance.Get()) - reference);
+  double compensatedError = std::abs(static_cast<double>(compensated.Get()) - reference);
+  std::printf("reference %.6f m\n", reference);
+  Check(naiveError > kExpectedFloatDrift, "float sum drifts", naiveError);
+  Check(countError < kAllowError, "CountDistance error", countError);
+  Check(compensatedError < kAllowError, "CompensatedSum error", compensatedError);
+  Check(countDistance.GetCount() == countedTotal, "CountDistance count", static_cast<double>(countDistance.GetCount()));
+
+  /* 100ms ごとにスリップ(車輪は1.5倍空転)を挟み、周期変位の和と走行距離が同じ値になることを確認する */
+  CountDistance slipDistance(kDistancePerCount);
+  CompensatedSum<float> mapped;
+  position = 0.0;
+  countedTotal = 0;
+  double wheelPosition = 0.0;
+  for (uint32_t tick = 0; position < kRunDistance; tick++) {
+    bool slipping = (tick / 100) % 2 == 1;
+    double velocity = 3.0 + 2.0 * std::sin(static_cast<double>(tick) * kPeriod);
+    position += velocity * kPeriod;
+    wheelPosition += (slipping ? 1.5 : 1.0) * velocity * kPeriod;
+    auto total = static_cast<int64_t>(std::floor(wheelPosition / kDistancePerCount));
+    auto delta = static_cast<int32_t>(total - countedTotal);
+    countedTotal = total;
+
+    /* スリップ中は推定速度(ここでは真の速度)からカウントを求める */
+    if (slipping) {
+      delta = slipDistance.AddDistance(static_cast<float>(velocity * kPeriod));
+    } else {
+      slipDistance.Add(delta);
+    }
+    mapped += slipDistance.ToDistance(delta);
+  }
+  double mappedError = std::abs(static_cast<double>(mapped.Get()) - static_cast<double>(slipDistance.Get()));
+  double slipError = std::abs(static_cast<double>(slipDistance.Get()) - position);
+  Check(mappedError < kAllowError, "slip map/distance mismatch", mappedError);
+  Check(slipError < kAllowSlipError, "slip distance error", slipError);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+/* コーナーでラインを見失った状態から、延長した経路へ見失った側に戻ることを確認する */
+
+/* C++ */
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <numbers>
+
+/* Project */
+#include "MotionPlaning/LineRecovery.h"
+
+namespace {
+constexpr float kRadius = 0.3f;         /* 左に曲がるコーナーの半径 [m] (中心は (0, kRadius)) */
+constexpr float kVelocity = 0.5f;       /* 復帰中の速度 [m/s] */
+constexpr float kPeriod = 1.0e-3f;      /* 周期 [s] */
+constexpr float kRunDistance = 0.6f;    /* 復帰で走る距離 [m] */
+constexpr float kAllowOffset = 5.0e-3f; /* 走り終えたときのラインからの許容ずれ [m] */
+constexpr float kDriftOffset = 0.03f;   /* 見失ったときの外側へのずれ [m] */
+constexpr float kDriftHeading = -0.3f;  /* 見失ったときのラインに対する向き (外側=右向き) [rad] */
+
+int failures = 0;
+
+void Check(bool condition, const char *name, double value) {
+  std::printf("%-32s %.6f %s\n", name, value, condition ? "OK" : "NG");
+  if (!condition) {
+    failures++;
+  }
+}
+
+/* 点から円弧までの横ずれ (ラインの左 = 円の内側が正) */
+float OffsetFromLine(float x, float y) { return kRadius - std::hypot(x, y - kRadius); }
+
+/* 円弧上の点での接線の向き */
+float TangentAt(float x, float y) { return std::atan2(y - kRadius, x) + std::numbers::pi_v<float> / 2.0f; }
+
+/* センサーの並び (車体の右向き) に沿って測ったラインまでの距離 (ラインが右にあれば正 = ラインの左が正) */
+float SensorOffset(float sensorX, float sensorY, float theta) {
+  float nx = std::sin(theta), ny = -std::cos(theta);
+  float dx = sensorX, dy = sensorY - kRadius;
+  /* |センサー + s n - 中心| = 半径 の近い方の解 */
+  float b = nx * dx + ny * dy;
+  float c = dx * dx + dy * dy - kRadius * kRadius;
+  float root = std::sqrt(b * b - c);
+  float s1 = -b + root, s2 = -b - root;
+  return std::abs(s1) < std::abs(s2) ? s1 : s2;
+}
+
+/* 見失ったときの姿勢から復帰を走らせ、走り終えたときのラインからのずれを返す */
+float Run(bool useOffset, float &firstAngularVelocity) {
+  /* 円弧上の角度 0.5 rad の位置から外側(右)へずれ、さらに外側を向いている */
+  float phi = 0.5f;
+  MotionSensing::Pose pose{};
+  pose.x = (kRadius + kDriftOffset) * std::sin(phi);
+  pose.y = kRadius - (kRadius + kDriftOffset) * std::cos(phi);
+  pose.theta = phi + kDriftHeading;
+
+  /* センサーで測る横ずれと、センサーが見ているライン上の点でのラインに対する向きを記録 */
+  float sensorX = pose.x + kLineDistanceFromCenter * std::cos(pose.theta);
+  float sensorY = pose.y + kLineDistanceFromCenter * std::sin(pose.theta);
+  float sensorOffset = useOffset ? SensorOffset(sensorX, sensorY, pose.theta) : 0.0f;
+  float lineX = sensorX + sensorOffset * std::sin(pose.theta);
+  float lineY = sensorY - sensorOffset * std::cos(pose.theta);
+  float heading =
+      useOffset ? std::remainder(pose.theta - TangentAt(lineX, lineY), 2.0f * std::numbers::pi_v<float>) : 0.0f;
+  MotionPlaning::LineRecovery recovery;
+  recovery.Record(pose, sensorOffset, heading, 1.0f / kRadius, 0.0f);
+  recovery.Start();
+
+  for (uint32_t tick = 0; static_cast<float>(tick) * kVelocity * kPeriod < kRunDistance; tick++) {
+    float angularVelocity = recovery.Update(pose, kVelocity);
+    if (tick == 0) {
+      firstAngularVelocity = angularVelocity;
+    }
+    pose.theta += angularVelocity * kPeriod;
+    pose.x += kVelocity * kPeriod * std::cos(pose.theta);
+    pose.y += kVelocity * kPeriod * std::sin(pose.theta);
+  }
+  return std::abs(OffsetFromLine(pose.x, pose.y));
+}
+}  // namespace
+
+int main() {
+  float firstAngularVelocity = 0.0f;
+  float offset = Run(true, firstAngularVelocity);
+  /* ラインは左(円の内側)にあるので、最初は左に曲がる(曲率の分より強く) */
+  Check(firstAngularVelocity > kVelocity / kRadius, "turns toward the lost line", firstAngularVelocity);
+  Check(offset < kAllowOffset, "converges to the line", offset);
+
+  /* 横ずれ・向きを0として記録すると、今の向きに延長した経路へ戻ってしまい収束しない */
+  float ignored = 0.0f;
+  float offsetWithoutState = Run(false, ignored);
+  Check(offsetWithoutState > kAllowOffset, "zero offset/heading misses", offsetWithoutState);
+  return failures == 0 ? 0 : 1;
+}
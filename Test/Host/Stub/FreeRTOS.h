@@ -0,0 +1,11 @@
+#ifndef TEST_HOST_STUB_FREERTOS_H_
+#define TEST_HOST_STUB_FREERTOS_H_
+
+/* ホスト向けテスト用のFreeRTOSの代わり (Config.h・Mutex.h の型だけ定義する) */
+#include <cstdint>
+
+typedef unsigned long UBaseType_t;
+typedef long BaseType_t;
+typedef uint32_t TickType_t;
+
+#endif  // TEST_HOST_STUB_FREERTOS_H_
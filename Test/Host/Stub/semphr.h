@@ -0,0 +1,10 @@
+#ifndef TEST_HOST_STUB_SEMPHR_H_
+#define TEST_HOST_STUB_SEMPHR_H_
+
+/* ホスト向けテスト用のFreeRTOSの代わり (Mutex.h の型だけ定義する) */
+#include <FreeRTOS.h>
+
+typedef void *SemaphoreHandle_t;
+struct StaticSemaphore_t {};
+
+#endif  // TEST_HOST_STUB_SEMPHR_H_